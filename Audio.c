@@ -0,0 +1,76 @@
+#ifndef NO_SDL
+#include <SDL/SDL.h>
+#include <stdatomic.h>
+#include "Audio.h"
+
+static atomic_uchar _buzzer; // buzzer is on
+static atomic_uchar _beeped; // buzzer was turned on since the last callback
+static u_int8_t _open;       // audio device is open
+static u_int8_t _silence;    // sample value of silence
+static u_int32_t _period;    // samples per period of the tone
+static u_int32_t _phase;     // sample of the period the next buffer starts at
+
+/*
+ * Audio callback: fill stream, len samples of 8 bits, with the tone if the
+ * buzzer is on or was turned on since the last call, silence otherwise.
+ */
+static void _fill(void* data, Uint8* stream, int len)
+{
+	int i;
+
+	(void) data;
+	if (!(atomic_exchange(&_beeped, 0) | atomic_load(&_buzzer))) {
+		memset(stream, _silence, len);
+		return;
+	}
+	for (i = 0; i < len; i++) {
+		stream[i] = _phase < _period / 2 ? _silence + TONE_VOLUME
+			: _silence - TONE_VOLUME;
+		_phase = (_phase + 1) % _period;
+	}
+}
+
+int open_audio(void)
+{
+	SDL_AudioSpec want;
+
+	want.freq = SAMPLE_RATE;
+	want.format = AUDIO_U8;
+	want.channels = 1;
+	want.samples = AUDIO_SAMPLES;
+	want.callback = _fill;
+	want.userdata = NULL;
+	atomic_init(&_buzzer, 0);
+	atomic_init(&_beeped, 0);
+	/* Without an obtained spec, SDL converts to the wanted one if it must */
+	if (SDL_OpenAudio(&want, NULL) < 0) {
+		printf("Could not open audio: %s\n", SDL_GetError());
+		return -1;
+	}
+	_silence = want.silence;
+	_period = SAMPLE_RATE / TONE_HZ;
+	_phase = 0;
+	_open = 1;
+	SDL_PauseAudio(0);
+	return 0;
+}
+
+void set_buzzer(u_int8_t on)
+{
+	if (!_open) {
+		return;
+	}
+	atomic_store_explicit(&_buzzer, on, memory_order_relaxed);
+	if (on) {
+		atomic_store_explicit(&_beeped, 1, memory_order_relaxed);
+	}
+}
+
+void close_audio(void)
+{
+	if (_open) {
+		SDL_CloseAudio();
+		_open = 0;
+	}
+}
+#endif
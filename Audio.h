@@ -0,0 +1,57 @@
+/*
+ * Buzzer of the SDL front end.
+ *
+ * The CHIP-8 has a single tone, sounded for as long as the sound timer is
+ * greater than 0. SDL plays it from a callback on its own audio thread, which
+ * fills each buffer with a square wave or silence by reading the buzzer state.
+ * The emulation thread only stores that state once per 60 Hz tick, into an
+ * atomic the callback loads; neither thread ever waits for the other, so
+ * sound can't hold up emulation. A tick the buzzer was turned on in is latched
+ * until the callback has played it, so even the shortest beep is heard.
+ *
+ * Headless runs never open the audio device nor set the buzzer, and the core
+ * makes no sound of its own.
+ *
+ * INFO:
+ * https://www.libsdl.org/release/SDL-1.2.15/docs/html/guideaudioexamples.html
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef AUDIO_H_
+#define AUDIO_H_
+
+/* INCLUDE */
+#include "InstructionSet.h"
+
+/* DEFINE */
+#define SAMPLE_RATE   44100 // samples per second played
+#define AUDIO_SAMPLES 512   // samples per callback, about 12 ms
+#define TONE_HZ       440   // pitch of the buzzer
+#define TONE_VOLUME   32    // amplitude of the square wave around silence
+
+#ifndef NO_SDL
+/* PROTOTYPES */
+/*
+ * Open the audio device and start playing the buzzer, silent until turned
+ * on. Returns 0 on success, -1 if there is no audio; the emulator then runs
+ * silently.
+ */
+int open_audio(void);
+
+/*
+ * Turn the buzzer on if on is set, off otherwise. Cheap enough to call every
+ * tick, and does nothing if the audio device isn't open.
+ */
+void set_buzzer(u_int8_t on);
+
+/*
+ * Stop playing and close the audio device.
+ */
+void close_audio(void);
+#endif
+
+#endif
@@ -0,0 +1,299 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Batch.h"
+#include "Quirks.h"
+#include "TranslationCache.h"
+
+/* Share of the jobs of a batch dealt to one worker */
+typedef struct share {
+	_Alignas(64) atomic_ulong next; // next job of the share to be taken
+	unsigned long end;              // one past the last job of the share
+} share;
+
+/* Everything the workers of a batch share */
+typedef struct batch {
+	const batch_job* jobs;
+	batch_result* results;
+	const headless_config* config;
+	u_int8_t engine;
+	u_int8_t quirks;
+	const char* translations;
+	unsigned workers;
+	share* shares;
+} batch;
+
+/* Argument of one worker thread */
+typedef struct worker {
+	batch* b;
+	unsigned id;
+} worker;
+
+int load_jobs(const char* path, u_int32_t seed, batch_job** jobs,
+	unsigned long* count)
+{
+	char line[2 * MAX_PATH + 32];
+	char script[MAX_PATH];
+	unsigned long n = 0;
+	unsigned long capacity = 16;
+	unsigned long job_seed;
+	batch_job* j;
+	batch_job* grown;
+	int fields;
+	FILE* f = fopen(path, "r");
+
+	if (!f) {
+		printf("Job list %s not found\n", path);
+		return -1;
+	}
+	*jobs = malloc(capacity * sizeof(batch_job));
+	*count = 0;
+	if (!*jobs) {
+		printf("Not enough memory for job list %s\n", path);
+		fclose(f);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		n++;
+		/* Lines may end in CRLF; blank ones may hold spaces */
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '#' || !line[strspn(line, " \t")]) {
+			continue;
+		}
+		if (*count == capacity) {
+			capacity *= 2;
+			grown = realloc(*jobs, capacity * sizeof(batch_job));
+			if (!grown) {
+				printf("Not enough memory for job list %s\n", path);
+				fclose(f);
+				free(*jobs);
+				return -1;
+			}
+			*jobs = grown;
+		}
+		j = &(*jobs)[*count];
+		script[0] = '\0';
+		fields = sscanf(line, "%255s %lu %255s", j->rom, &job_seed, script);
+		if (fields < 1) {
+			printf("Malformed job list %s at line %lu\n", path, n);
+			fclose(f);
+			free(*jobs);
+			return -1;
+		}
+		j->seed = fields >= 2 ? job_seed : seed;
+		strcpy(j->script, script);
+		(*count)++;
+	}
+	fclose(f);
+	return 0;
+}
+
+/*
+ * Run job j of batch b on a machine of its own.
+ */
+static void _run_job(batch* b, unsigned long j)
+{
+	const batch_job* job = &b->jobs[j];
+	batch_result* result = &b->results[j];
+	headless_config config = *b->config;
+	input_script script = { NULL, 0 };
+	chip8* c = malloc(sizeof(chip8));
+
+	memset(result, 0, sizeof(batch_result));
+	if (!c) {
+		result->error = 1;
+		return;
+	}
+	initialize(c);
+	seed_rng(c, job->seed);
+	config.input = NULL;
+	if (load_rom(c, job->rom) || set_engine(c, b->engine)
+		|| (job->script[0] && load_script(job->script, &script))) {
+		result->error = 1;
+	} else {
+		set_quirks(c, b->quirks);
+		/* Warming is only worth having: a cold machine runs all the same */
+		if (b->translations && warm_translation(c, b->translations)) {
+			fprintf(stderr, "Not enough memory to warm %s, running it cold\n",
+				job->rom);
+		}
+		if (job->script[0]) {
+			config.input = &script;
+		}
+		run_headless(c, &config, &result->run);
+		result->hash = screen_hash(c);
+	}
+	free_script(&script);
+	release(c);
+	free(c);
+}
+
+/*
+ * Run jobs of the batch until none are left: first those of the worker's own
+ * share, then those left in the shares of the others.
+ */
+static void* _work(void* arg)
+{
+	worker* w = arg;
+	batch* b = w->b;
+	share* s;
+	unsigned long j;
+	unsigned i;
+
+	for (i = 0; i < b->workers; i++) {
+		s = &b->shares[(w->id + i) % b->workers];
+		while ((j = atomic_fetch_add(&s->next, 1)) < s->end) {
+			_run_job(b, j);
+		}
+	}
+	return NULL;
+}
+
+int run_batch(const batch_job* jobs, unsigned long count,
+	const headless_config* config, u_int8_t engine, u_int8_t quirks,
+	const char* translations, unsigned threads, batch_result* results)
+{
+	batch b = { jobs, results, config, engine, quirks, translations, threads,
+		NULL };
+	pthread_t* ids;
+	worker* workers;
+	unsigned started;
+	unsigned i;
+
+	if (!b.workers) {
+		b.workers = sysconf(_SC_NPROCESSORS_ONLN) > 0
+			? sysconf(_SC_NPROCESSORS_ONLN) : 1;
+	}
+	if (b.workers > count) {
+		b.workers = count ? count : 1;
+	}
+	/* Jobs still run without the cache, translating every time */
+	if (translations && access(translations, R_OK | W_OK | X_OK)) {
+		perror(translations);
+	}
+
+	/* Workers only read the decode table, so it must be built beforehand */
+	build_decode_table();
+
+	b.shares = aligned_alloc(64, b.workers * sizeof(share));
+	ids = malloc(b.workers * sizeof(pthread_t));
+	workers = malloc(b.workers * sizeof(worker));
+	if (!b.shares || !ids || !workers) {
+		free(b.shares);
+		free(ids);
+		free(workers);
+		return -1;
+	}
+	for (i = 0; i < b.workers; i++) {
+		atomic_init(&b.shares[i].next, count * i / b.workers);
+		b.shares[i].end = count * (i + 1) / b.workers;
+		workers[i].b = &b;
+		workers[i].id = i;
+	}
+
+	/*
+	 * The calling thread is the first worker. Should a thread fail to start,
+	 * its share is stolen by those that did
+	 */
+	for (started = 1; started < b.workers; started++) {
+		if (pthread_create(&ids[started], NULL, _work, &workers[started])) {
+			break;
+		}
+	}
+	_work(&workers[0]);
+	for (i = 1; i < started; i++) {
+		pthread_join(ids[i], NULL);
+	}
+
+	free(b.shares);
+	free(ids);
+	free(workers);
+	return 0;
+}
+
+u_int64_t screen_hash(const chip8* c)
+{
+	u_int64_t hash = 0xCBF29CE484222325ULL;
+	int y;
+	int k;
+	int b;
+
+	/* FNV-1a over the bytes of the screen shown, leftmost pixels first */
+	if (c->hires) {
+		for (y = 0; y < HIRES_HEIGHT; y++) {
+			for (k = 0; k < HIRES_WORDS; k++) {
+				for (b = 56; b >= 0; b -= 8) {
+					hash = (hash ^ ((HIRES_ROW(c, y)[k] >> b) & 0xFF))
+						* 0x100000001B3ULL;
+				}
+			}
+		}
+		return hash;
+	}
+	for (y = 0; y < HEIGHT; y++) {
+		for (b = WIDTH - 8; b >= 0; b -= 8) {
+			hash = (hash ^ ((c->screen[y] >> b) & 0xFF)) * 0x100000001B3ULL;
+		}
+	}
+	return hash;
+}
+
+/*
+ * Name why the run of result ended.
+ */
+static const char* _reason(const batch_result* result)
+{
+	if (result->error) {
+		return "error";
+	}
+	switch (result->run.halt) {
+		case HALT_OVERFLOW:
+			return "overflow";
+		case HALT_UNDERFLOW:
+			return "underflow";
+		case HALT_UNKNOWN:
+			return "unknown";
+		case HALT_EXIT:
+			return "exit";
+		default:
+			return "limit";
+	}
+}
+
+/*
+ * Write s to f as a CSV field, quoted as RFC 4180 asks if it holds a comma,
+ * quote or line break.
+ */
+static void _write_field(FILE* f, const char* s)
+{
+	if (!s[strcspn(s, ",\"\r\n")]) {
+		fputs(s, f);
+		return;
+	}
+	fputc('"', f);
+	for (; *s; s++) {
+		if (*s == '"') {
+			fputc('"', f);
+		}
+		fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+void write_results(FILE* f, const batch_job* jobs,
+	const batch_result* results, unsigned long count)
+{
+	unsigned long j;
+
+	fprintf(f, "rom,seed,script,cycles,frames,hash,reason\n");
+	for (j = 0; j < count; j++) {
+		_write_field(f, jobs[j].rom);
+		fprintf(f, ",%u,", jobs[j].seed);
+		_write_field(f, jobs[j].script);
+		fprintf(f, ",%lu,%lu,%016llX,%s\n", results[j].run.cycles,
+			results[j].run.frames, (unsigned long long) results[j].hash,
+			_reason(&results[j]));
+	}
+}
@@ -0,0 +1,98 @@
+/*
+ * Parallel batch runs of CHIP-8 ROMs.
+ *
+ * A batch is a list of jobs, each a ROM run headless (see Headless.h) with its
+ * own seed and optionally its own input script, so that one ROM can be run
+ * with many seeds or scripts as easily as many ROMs. Every job runs on its own
+ * machine, so jobs share nothing but the decode table and run on a pool of
+ * worker threads, by default one per core.
+ *
+ * Jobs are dealt out to the workers in contiguous shares. Each worker takes
+ * the next job of its own share, and once its share is done steals the next
+ * jobs from the shares of the others, so that workers given slow jobs do not
+ * hold up the batch while others sit idle.
+ *
+ * A job list is a text file holding one job per line in the form
+ *     <rom> [seed] [script]
+ * where seed seeds the random number generator of the job's machine and
+ * script is an input script. Jobs without a seed use the seed of the batch.
+ * Lines may end in CRLF. Blank lines, even holding spaces, and lines starting
+ * with '#' are ignored.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef BATCH_H_
+#define BATCH_H_
+
+/* INCLUDE */
+#include <stdio.h>
+#include "Headless.h"
+
+/* DEFINE */
+#define MAX_PATH 256 // longest ROM or input script path in a job list
+
+/* TYPEDEFS */
+/* One run of a batch */
+typedef struct batch_job {
+	char rom[MAX_PATH];    // ROM to run
+	char script[MAX_PATH]; // input script, empty for none
+	u_int32_t seed;        // seed of the random number generator
+} batch_job;
+
+/* Outcome of one run of a batch */
+typedef struct batch_result {
+	headless_result run; // cycles and frames run, and why the run ended
+	u_int64_t hash;      // hash of the screen once the run ended
+	u_int8_t error;      // the ROM or input script could not be loaded
+} batch_result;
+
+/* PROTOTYPES */
+/*
+ * Read the job list at path into jobs, holding count jobs, giving jobs
+ * without a seed the seed given.
+ *
+ * Returns 0 on success, after which jobs must be freed. If the file can't be
+ * opened or a line is malformed, an error message is printed and -1 is
+ * returned.
+ */
+int load_jobs(const char* path, u_int32_t seed, batch_job** jobs,
+	unsigned long* count);
+
+/*
+ * Run the count jobs on threads worker threads, 0 for one per core, each on
+ * its own machine running on engine with the quirk profile quirks (see
+ * Quirks.h; QUIRKS_AUTO picks one per ROM) and the limits of config; write
+ * the outcome of job j to results[j]. Unless translations is NULL, each
+ * machine is warmed from the translation cache in that directory first (see
+ * TranslationCache.h). Warming is best effort: if the directory can't be
+ * used or a machine can't be warmed, this is printed to stderr and the jobs
+ * run all the same.
+ *
+ * The input of config is ignored; each job reads its own input script.
+ * Returns -1 if there isn't enough memory to start the workers, 0 otherwise.
+ */
+int run_batch(const batch_job* jobs, unsigned long count,
+	const headless_config* config, u_int8_t engine, u_int8_t quirks,
+	const char* translations, unsigned threads, batch_result* results);
+
+/*
+ * Hash the screen machine c shows, the CHIP-8 or the hi-res one. Machines
+ * showing the same pixels hash alike.
+ */
+u_int64_t screen_hash(const chip8* c);
+
+/*
+ * Write the outcome of the count jobs to f as CSV with a header line, one line
+ * per job in the order of the job list: the ROM, seed, input script, cycles,
+ * frames, screen hash, and why the run ended (limit, overflow, underflow,
+ * unknown, exit, or error). Paths holding a comma, quote or line break are
+ * quoted as RFC 4180 asks.
+ */
+void write_results(FILE* f, const batch_job* jobs,
+	const batch_result* results, unsigned long count);
+
+#endif
@@ -0,0 +1,167 @@
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Batch.h"
+#include "Benchmark.h"
+#include "Display.h"
+#include "Quirks.h"
+#include "Scheduler.h"
+
+#ifdef SWITCH_DISPATCH
+#define DISPATCH "switch"
+#else
+#define DISPATCH "table"
+#endif
+
+static const char* const _engines[] = { "interp", "cache", "block" };
+
+/*
+ * Return the number of bytes of heap in use, or -1 if unknown.
+ */
+static long _heap()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	struct mallinfo2 m = mallinfo2();
+
+	return m.uordblks + m.hblkhd;
+#else
+	return -1;
+#endif
+}
+
+/*
+ * Run job on engine with quirks and print how it went to f.
+ */
+static void _run(const batch_job* job, u_int8_t engine, u_int8_t quirks,
+	const headless_config* config, FILE* f)
+{
+	headless_config run = *config;
+	headless_result result;
+	input_script script = { NULL, 0 };
+	chip8 c;
+	long start;
+	long engine_heap;
+	long run_heap;
+	u_int64_t begin;
+	double seconds;
+	double ips = 0;
+	double fps = 0;
+
+	start = _heap();
+	initialize(&c);
+	seed_rng(&c, job->seed);
+	if (load_rom(&c, job->rom) || set_engine(&c, engine)
+		|| (job->script[0] && load_script(job->script, &script))) {
+		/* Every run of the corpus gets a line, even one which never ran */
+		fprintf(f, "rom=%s engine=%s dispatch=%s error=1\n", job->rom,
+			_engines[engine], DISPATCH);
+		release(&c);
+		return;
+	}
+	set_quirks(&c, quirks);
+	run.input = job->script[0] ? &script : NULL;
+	engine_heap = _heap() - start;
+
+	begin = monotonic_ns();
+	run_headless(&c, &run, &result);
+	seconds = (monotonic_ns() - begin) / (double) NS_PER_SEC;
+	run_heap = _heap() - start - engine_heap;
+	if (start < 0) {
+		engine_heap = run_heap = -1;
+	}
+	/* Instructions skipped while idle took no time, so they don't count */
+	if (seconds > 0) {
+		ips = result.executed / seconds;
+		fps = result.frames / seconds;
+	}
+
+	fprintf(f, "rom=%s engine=%s dispatch=%s quirks=%s cycles=%lu"
+		" executed=%lu frames=%lu seconds=%.6f ips=%.0f fps=%.0f"
+		" engine_heap=%ld run_heap=%ld halt=%u\n", job->rom,
+		_engines[engine], DISPATCH, quirk_profiles[c.quirks]->name,
+		result.cycles, result.executed, result.frames, seconds, ips, fps,
+		engine_heap, run_heap, result.halt);
+	free_script(&script);
+	release(&c);
+}
+
+/*
+ * Time DRW of the quirk profile quirks drawing 15-line sprites all over the
+ * screen, printing the time per call to f.
+ */
+static void _bench_drw(u_int8_t quirks, FILE* f)
+{
+	chip8 c;
+	decoded d = { OP_DRW, 0, 1, 15, 0, 0 };
+	u_int64_t begin;
+	u_int32_t j;
+
+	initialize(&c);
+	set_quirks(&c, quirks);
+	for (j = 0; j < 15; j++) {
+		c.RAM[0x300 + j] = 0xA5 ^ j;
+	}
+	c.I = 0x300;
+	begin = monotonic_ns();
+	for (j = 0; j < BENCH_CALLS; j++) {
+		c.v[0] = j * 7;
+		c.v[1] = j * 3;
+		c.handlers[OP_DRW](&c, &d);
+	}
+	fprintf(f, "bench=drw calls=%u ns=%.2f\n", BENCH_CALLS,
+		(double) (monotonic_ns() - begin) / BENCH_CALLS);
+}
+
+/*
+ * Time expanding the whole screen onto an emulator screen, as refresh_screen
+ * does when every row changed, printing the time per call to f.
+ */
+static void _bench_refresh(FILE* f)
+{
+	u_int32_t* pixels = malloc(EMU_W * EMU_H * sizeof(u_int32_t));
+	u_int64_t screen[HEIGHT];
+	u_int64_t begin;
+	u_int32_t calls = BENCH_CALLS / 100;
+	u_int32_t j;
+
+	if (!pixels) {
+		return;
+	}
+	for (j = 0; j < HEIGHT; j++) {
+		screen[j] = 0x0123456789ABCDEFULL * (j + 1);
+	}
+	begin = monotonic_ns();
+	for (j = 0; j < calls; j++) {
+		screen[j % HEIGHT] ^= j;
+		expand_rows(screen, ALL_ROWS, pixels, EMU_W);
+	}
+	fprintf(f, "bench=refresh calls=%u ns=%.2f\n", calls,
+		(double) (monotonic_ns() - begin) / calls);
+	free(pixels);
+}
+
+int run_benchmark(const char* corpus, const headless_config* config,
+	u_int8_t quirks, FILE* f)
+{
+	headless_config limits = *config;
+	batch_job* jobs;
+	unsigned long count;
+	unsigned long j;
+	u_int8_t engine;
+
+	if (load_jobs(corpus, DEFAULT_SEED, &jobs, &count)) {
+		return -1;
+	}
+	if (!limits.cycles && !limits.frames) {
+		limits.cycles = BENCH_CYCLES;
+	}
+	for (j = 0; j < count; j++) {
+		for (engine = ENGINE_INTERP; engine <= ENGINE_BLOCK; engine++) {
+			_run(&jobs[j], engine, quirks, &limits, f);
+		}
+	}
+	_bench_drw(quirks == QUIRKS_AUTO ? QUIRKS_DEFAULT : quirks, f);
+	_bench_refresh(f);
+	free(jobs);
+	return 0;
+}
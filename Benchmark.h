@@ -0,0 +1,55 @@
+/*
+ * Performance benchmarks of the CHIP-8 emulator.
+ *
+ * A benchmark runs every ROM of a corpus headless for a fixed number of
+ * instructions on each execution engine in turn, timing each run by the
+ * monotonic clock, and then times DRW and the expansion of the screen which
+ * refresh_screen performs on their own. Every result is printed as one line
+ * of key=value pairs so that results can be compared between builds:
+ *     rom=<rom> engine=<engine> dispatch=<switch|table> quirks=<profile>
+ *         cycles=<n> executed=<n> frames=<n> seconds=<s> ips=<n> fps=<n>
+ *         engine_heap=<bytes> run_heap=<bytes> halt=<HALT_ value>
+ *     rom=<rom> engine=<engine> dispatch=<switch|table> error=1
+ *     bench=drw calls=<n> ns=<ns per DRW>
+ *     bench=refresh calls=<n> ns=<ns per full screen expansion>
+ * where cycles counts the instructions run as a headless run does, including
+ * those skipped while the machine waited idle for a key or the delay timer,
+ * and executed only those actually executed; ips is executed per second.
+ * engine_heap is the heap the execution engine holds and run_heap is how much
+ * the heap grew while the ROM ran, which should be 0; both are -1 where the C
+ * library can't tell. The line with error=1 stands in for a run whose ROM,
+ * engine or input script couldn't be loaded. Dispatch is chosen when
+ * compiling, by SWITCH_DISPATCH, so comparing the two takes one build of each.
+ *
+ * The corpus is a job list as read by load_jobs (see Batch.h); the seed and
+ * input script of each job are used for its runs.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+/* INCLUDE */
+#include <stdio.h>
+#include "Headless.h"
+
+/* DEFINE */
+#define BENCH_CYCLES 10000000 // instructions per run, unless limited otherwise
+#define BENCH_CALLS  1000000  // calls timed by each kernel benchmark
+
+/* PROTOTYPES */
+/*
+ * Benchmark the ROMs of the job list at corpus with the limits of config, or
+ * BENCH_CYCLES instructions if config sets none, and with the quirk profile
+ * quirks (see Quirks.h), writing the results to f.
+ *
+ * Returns -1 if the corpus could not be read, 0 otherwise.
+ */
+int run_benchmark(const char* corpus, const headless_config* config,
+	u_int8_t quirks, FILE* f);
+
+#endif
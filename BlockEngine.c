@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "BlockEngine.h"
+#include "Profile.h"
+#include "Trace.h"
+
+/* Operations which end a basic block */
+static const u_int8_t ends_block[NUM_OPS] = {
+	[OP_UNKNOWN] = 1, [OP_RET] = 1, [OP_JP] = 1, [OP_CALL] = 1, [OP_SE] = 1,
+	[OP_SNEI] = 1, [OP_SR] = 1, [OP_SNE] = 1, [OP_JPR] = 1, [OP_DRW] = 1,
+	[OP_SKP] = 1, [OP_SKNP] = 1, [OP_LDK] = 1, [OP_BCD] = 1, [OP_STA] = 1,
+	[OP_SCD] = 1, [OP_SCR] = 1, [OP_SCL] = 1, [OP_EXIT] = 1, [OP_LOW] = 1,
+	[OP_HIGH] = 1, [OP_DRWX] = 1
+};
+
+int alloc_blocks(chip8* c)
+{
+	if (!c->blocks) {
+		c->blocks = malloc(sizeof(translation));
+		if (!c->blocks) {
+			return -1;
+		}
+		c->blocks->flushes = 0;
+		flush_blocks(c);
+	}
+	return 0;
+}
+
+void flush_blocks(chip8* c)
+{
+	translation* t = c->blocks;
+
+	if (t) {
+		memset(t->lookup, 0, sizeof(t->lookup));
+		memset(t->in_page, 0, sizeof(t->in_page));
+		t->pages = 0;
+		t->num_blocks = 1;
+		t->num_code = 0;
+		t->flushes++;
+	}
+}
+
+void index_block(chip8* c, u_int16_t id)
+{
+	translation* t = c->blocks;
+	const block* b = &t->blocks[id];
+	int p;
+	int k;
+
+	t->lookup[MEM(b->start)] = id;
+	for (k = 0; k < 2 * b->length; k++) {
+		p = MEM(b->start + k) / SIZE_PAGE;
+		t->in_page[p][id / 64] |= 1ULL << (id % 64);
+		t->pages |= 1ULL << p;
+	}
+}
+
+/*
+ * Discard block id of translation t: nothing looks it up or chains to it any
+ * more, and no page holds it.
+ */
+static void _discard(translation* t, u_int16_t id)
+{
+	block* b = &t->blocks[id];
+	int j, k, p, w;
+
+	t->lookup[MEM(b->start)] = 0;
+	for (k = 0; k < 2 * b->length; k++) {
+		p = MEM(b->start + k) / SIZE_PAGE;
+		t->in_page[p][id / 64] &= ~(1ULL << (id % 64));
+		for (w = 0; w < BLOCK_WORDS && !t->in_page[p][w]; w++);
+		if (w == BLOCK_WORDS) {
+			t->pages &= ~(1ULL << p);
+		}
+	}
+	b->length = 0;
+	for (j = 1; j < t->num_blocks; j++) {
+		for (k = 0; k < NUM_EXITS; k++) {
+			if (t->blocks[j].next[k] == id) {
+				t->blocks[j].exit[k] = 0;
+				t->blocks[j].next[k] = 0;
+			}
+		}
+	}
+}
+
+void invalidate_blocks(chip8* c, address a)
+{
+	translation* t = c->blocks;
+	int p = MEM(a) / SIZE_PAGE;
+	u_int64_t in;
+	u_int16_t id;
+	int w;
+
+	if (!(t->pages & (1ULL << p))) {
+		return;
+	}
+	for (w = 0; w < BLOCK_WORDS; w++) {
+		for (in = t->in_page[p][w]; in; in &= in - 1) {
+			id = w * 64 + __builtin_ctzll(in);
+			/* Blocks wrap around the end of memory as PC does */
+			if (MEM(a - t->blocks[id].start) < 2 * t->blocks[id].length) {
+				_discard(t, id);
+			}
+		}
+	}
+}
+
+/*
+ * Translate the basic block of machine c starting at address pc, returning the
+ * block's number. If there is no more room for the block, every block is
+ * discarded first.
+ */
+static u_int16_t _translate(chip8* c, address pc)
+{
+	translation* t = c->blocks;
+	threaded* th;
+	block* b;
+	address a = pc;
+	int k;
+
+	if (t->num_blocks == MAX_BLOCKS || t->num_code + MAX_LENGTH > MAX_CODE) {
+		flush_blocks(c);
+	}
+	b = &t->blocks[t->num_blocks];
+	b->start = pc;
+	b->length = 0;
+	b->code = t->num_code;
+	for (k = 0; k < NUM_EXITS; k++) {
+		b->exit[k] = 0;
+		b->next[k] = 0;
+	}
+	do {
+		th = &t->code[b->code + b->length++];
+		predecode(INSTR(c->RAM[MEM(a)], c->RAM[MEM(a + 1)]), &th->d);
+		th->fn = c->handlers[th->d.op];
+		a += 2;
+	} while (!ends_block[th->d.op] && b->length < MAX_LENGTH);
+	t->num_code += b->length;
+	index_block(c, t->num_blocks);
+	return t->num_blocks++;
+}
+
+void discover_blocks(chip8* c, address pc)
+{
+	translation* t = c->blocks;
+	address todo[SIZE_MEM];
+	address last;
+	block* b;
+	int pending = 0;
+
+	todo[pending++] = MEM(pc);
+	while (pending) {
+		pc = todo[--pending];
+		if (t->lookup[pc]) {
+			continue;
+		}
+		if (t->num_blocks == MAX_BLOCKS || t->num_code + MAX_LENGTH > MAX_CODE) {
+			break;
+		}
+		b = &t->blocks[_translate(c, pc)];
+		last = b->start + 2 * (b->length - 1);
+
+		/* Queue where PC may go after the block */
+		switch (t->code[b->code + b->length - 1].d.op) {
+			case OP_RET: case OP_JPR: case OP_UNKNOWN: case OP_EXIT:
+				/* Nowhere known before running */
+				break;
+			case OP_JP:
+				todo[pending++] = t->code[b->code + b->length - 1].d.nnn;
+				break;
+			case OP_CALL:
+				todo[pending++] = MEM(last + 2);
+				todo[pending++] = t->code[b->code + b->length - 1].d.nnn;
+				break;
+			case OP_SE: case OP_SNEI: case OP_SR: case OP_SNE: case OP_SKP:
+			case OP_SKNP:
+				todo[pending++] = MEM(last + 4);
+				todo[pending++] = MEM(last + 2);
+				break;
+			default:
+				todo[pending++] = MEM(last + 2);
+				break;
+		}
+		/* Each block queues at most 2 addresses; stop before running out */
+		if (pending > SIZE_MEM - 2) {
+			break;
+		}
+	}
+}
+
+u_int32_t run_blocks(chip8* c, u_int32_t n)
+{
+	translation* t = c->blocks;
+	u_int32_t executed = 0;
+	u_int32_t flushes;
+	u_int16_t prev = 0;
+	u_int16_t id;
+	threaded* th;
+	threaded* end;
+	block* b;
+	int k;
+
+	while (executed < n && !c->halt && !c->idle) {
+		/* Follow the chain from the previous block if it leads to PC */
+		id = 0;
+		if (prev) {
+			b = &t->blocks[prev];
+			for (k = 0; k < NUM_EXITS; k++) {
+				if (b->exit[k] == c->PC && b->next[k]) {
+					id = b->next[k];
+					break;
+				}
+			}
+		}
+		if (!id) {
+			flushes = t->flushes;
+			id = t->lookup[MEM(c->PC)];
+			if (!id) {
+				id = _translate(c, c->PC);
+			}
+			/* Chain the previous block to this one if both still exist */
+			if (prev && flushes == t->flushes) {
+				b = &t->blocks[prev];
+				for (k = NUM_EXITS - 1; k > 0; k--) {
+					b->exit[k] = b->exit[k - 1];
+					b->next[k] = b->next[k - 1];
+				}
+				b->exit[0] = c->PC;
+				b->next[0] = id;
+			}
+		}
+
+		b = &t->blocks[id];
+		th = &t->code[b->code];
+		end = th + (b->length < n - executed ? b->length : n - executed);
+		executed += end - th;
+		flushes = t->flushes;
+		for (; th < end; th++) {
+			TRACE_RECORD(c, c->PC, &th->d);
+			PROFILE_RECORD(c, c->PC, &th->d);
+			c->PC += 2;
+			th->fn(c, &th->d);
+		}
+		/* A write to the block itself leaves nothing to chain from */
+		prev = flushes == t->flushes && b->length ? id : 0;
+	}
+	return executed;
+}
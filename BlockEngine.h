@@ -0,0 +1,120 @@
+/*
+ * Basic block translation engine for the CHIP-8 emulator.
+ *
+ * A basic block is a run of instructions which are always executed one after
+ * the other: it starts at whichever address PC jumps to and ends with the first
+ * instruction which may change PC in any way other than moving on to the next
+ * instruction (JP, CALL, RET, JPR, the skip instructions, and LDK), draws to the
+ * screen (DRW, DRWX, the scrolls, LOW and HIGH), writes to memory (BCD, STA),
+ * exits, or is unknown.
+ *
+ * The first time PC reaches a block, the block is translated into threaded
+ * code: an array holding, for each instruction, the method executing it and
+ * its operands already unpacked. Running the block then only calls these
+ * methods in turn, without fetching or decoding anything. Each block also
+ * remembers which blocks followed it the last times it ran so that most jumps
+ * between blocks need no lookup.
+ *
+ * A write to memory holding translated code discards the blocks holding the
+ * address written, and the chains leading into them, so that ROMs which
+ * modify their own code keep running correctly. Each page of memory keeps
+ * which blocks lie in it, so a write beside code, to data sharing its page,
+ * only checks those blocks and discards none. Since blocks end at every
+ * instruction which writes to memory, no block is ever discarded while any
+ * but its last instruction is running. Once the table of blocks is full,
+ * every block is discarded at once.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef BLOCKENGINE_H_
+#define BLOCKENGINE_H_
+
+/* INCLUDE */
+#include "CHIP8Emulator.h"
+
+#define MAX_BLOCKS 512  // number of blocks held before all are discarded
+#define MAX_CODE   4096 // number of instructions held before all are discarded
+#define MAX_LENGTH 64   // maximum number of instructions in one block
+#define NUM_EXITS  2    // number of following blocks each block remembers
+#define NUM_PAGES  (SIZE_MEM / SIZE_PAGE)
+#define BLOCK_WORDS (MAX_BLOCKS / 64) // words of a bitmap of every block
+
+/* Instruction translated into threaded code */
+typedef struct threaded {
+	handler fn; // method executing the instruction
+	decoded d;  // the instruction, decoded
+} threaded;
+
+/* Basic block of translated instructions */
+typedef struct block {
+	u_int16_t start;            // address of the first instruction
+	u_int16_t length;           // number of instructions, 0 once discarded
+	u_int16_t code;             // index of the first instruction in code
+	u_int16_t exit[NUM_EXITS];  // addresses PC held after the block last ran
+	u_int16_t next[NUM_EXITS];  // blocks starting at those addresses
+} block;
+
+/*
+ * Translated blocks of one machine. Blocks are numbered from 1; block 0 stands
+ * for no block.
+ */
+typedef struct translation {
+	u_int16_t lookup[SIZE_MEM];   // block starting at each address
+	u_int64_t pages;              // bit p set if page p holds translated code
+	u_int64_t in_page[NUM_PAGES][BLOCK_WORDS]; // blocks lying in each page
+	u_int16_t num_blocks;         // number of blocks, including block 0
+	u_int16_t num_code;           // number of instructions in code
+	u_int32_t flushes;            // number of times every block was discarded
+	block blocks[MAX_BLOCKS];
+	threaded code[MAX_CODE];
+} translation;
+
+/* PROTOTYPES */
+/*
+ * Allocate the translated blocks of machine c if not yet allocated.
+ *
+ * Returns -1 if there isn't enough memory, 0 otherwise.
+ */
+int alloc_blocks(chip8* c);
+
+/*
+ * Discard every translated block of machine c.
+ */
+void flush_blocks(chip8* c);
+
+/*
+ * Make block id of machine c, translated from memory, the one starting at its
+ * start address, and note the pages it lies in.
+ */
+void index_block(chip8* c, u_int16_t id);
+
+/*
+ * Discard every translated block of machine c holding memory address a.
+ */
+void invalidate_blocks(chip8* c, address a);
+
+/*
+ * Translate every basic block of machine c which can be reached from address
+ * pc by following jumps, calls, skips and the instructions which fall through
+ * to the next, without running anything. Blocks only reached through RET or
+ * JPR are left to be translated when first run. Stops once there is no more
+ * room for blocks rather than discarding any.
+ */
+void discover_blocks(chip8* c, address pc);
+
+/*
+ * Execute up to n instructions on machine c by running its translated blocks,
+ * translating blocks the first time they're reached.
+ *
+ * If fewer than the number of instructions remaining in a block are left to
+ * execute, only that many of its instructions are run so that exactly n
+ * instructions are executed unless the machine halts. Returns the number of
+ * instructions which were executed.
+ */
+u_int32_t run_blocks(chip8* c, u_int32_t n);
+
+#endif
@@ -1,378 +1,480 @@
-#include <SDL/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 #include "CHIP8Emulator.h"
+#include "Batch.h"
+#include "Benchmark.h"
+#include "BlockEngine.h"
+#include "Headless.h"
+#include "Profile.h"
+#include "Quirks.h"
+#include "RomCache.h"
+#include "SaveState.h"
+#include "Scheduler.h"
+#include "SDLFrontend.h"
+#include "Stream.h"
+#include "Trace.h"
+#include "TranslationCache.h"
 
-u_int8_t emulator_keys[NUM_KEYS] = {
-	SDLK_x, SDLK_1, SDLK_2, SDLK_3, SDLK_q, SDLK_w, SDLK_e, SDLK_a,
-	SDLK_s, SDLK_d, SDLK_z, SDLK_c, SDLK_4, SDLK_r, SDLK_f, SDLK_v
-};
+u_int8_t decode_table[0x10000];
 
-void initialize()
+void initialize(chip8* c)
 {
+	/* Decoding is shared by every machine and only needs to be done once */
+	build_decode_table();
+
 	/* Initialize variables */
-	PC = 0x200;
-	I  = 0;
-	sp = (address*) &RAM[STACK_LOW];
+	c->PC = 0x200;
+	c->I  = 0;
+	c->sp = STACK_LOW;
 
 	/* Clear registers V0 - VF */
-	memset(v, 0, NUM_REGS);
+	memset(c->v, 0, NUM_REGS);
 
 	/* Clear keys */
-	memset(keys, 0, NUM_KEYS);
+	memset(c->keys, 0, NUM_KEYS);
 
-	/* Clear screen */
-	CLS();
+	/* Clear both screens, showing the CHIP-8 one */
+	c->hires = 1;
+	CLS(c, NULL);
+	c->hires = 0;
+	CLS(c, NULL);
+	memset(c->flags, 0, NUM_FLAGS);
 
 	/* Clear memory and calling stack */
-	memset(RAM, 0, SIZE_MEM);
+	memset(c->RAM, 0, SIZE_MEM);
 
-	/* Load font set */
-	memcpy(RAM, font_set, SIZE_FS);
+	/* Load font sets */
+	memcpy(c->RAM, font_set, SIZE_FS);
+	memcpy(c->RAM + BIG_FONT, big_font_set, SIZE_BFS);
 
-	/* Seed rand */
-	srand(time(NULL));
+	/* Seed the random number generator */
+	seed_rng(c, DEFAULT_SEED);
 
 	/* Clear timers */
-	delay_timer = 0;
-	sound_timer = 0;
+	c->delay_timer = 0;
+	c->sound_timer = 0;
 
 	/* Clear draw flag */
-	draw = 0;
+	c->draw = 0;
+
+	/* Machine is ready to run */
+	c->halt = HALT_NONE;
+	c->idle = 0;
+
+#ifdef TRACE
+	/* Start with an empty trace */
+	c->trace_next = 0;
+#endif
+
+	/* Start with an empty profile */
+	clear_profile(c);
+
+	/* Run on the plain interpreter until told otherwise */
+	c->engine = ENGINE_INTERP;
+	c->cache = NULL;
+	c->blocks = NULL;
+
+	/* Run with the quirks of this emulator until told otherwise */
+	set_quirks(c, QUIRKS_DEFAULT);
+
+	/* Nothing has been written yet */
+	c->touched = 0;
 }
 
-instruction fetch()
+instruction fetch(chip8* c)
 {
-	instruction i = INSTR(RAM[PC], RAM[PC + 1]);
-	PC += 2;
+	instruction i = INSTR(c->RAM[MEM(c->PC)], c->RAM[MEM(c->PC + 1)]);
+	c->PC += 2;
 	return i;
 }
 
-void execute(instruction i)
+u_int8_t decode(instruction i)
 {
 	/* Most Significant Nibble can be used to decode most instructions */
 	u_int8_t msn = MSN(i);
 	u_int8_t lsn = LSN(i);
 
-	printf("Executing 0x%04X at PC = 0x%04X, I = 0x%04X\n", i, PC - 2, I);
-	/* Decode and execute */
+	/* Decode */
 	switch (msn) {
 		case 0x0:
 			if (i == 0x00E0) {
 				// 00E0 CLS: clear screen
-				CLS();
-				return;
+				return OP_CLS;
 			}
 			if (i == 0x00EE) {
 				// 00EE RET: return from subroutine
-				RET();
-				return;
+				return OP_RET;
+			}
+			if ((i & 0xFFF0) == 0x00C0) {
+				// 00Cn SCD: scroll screen down n rows
+				return OP_SCD;
+			}
+			switch (i) {
+				case 0x00FB:
+					// 00FB SCR: scroll screen right 4 pixels
+					return OP_SCR;
+				case 0x00FC:
+					// 00FC SCL: scroll screen left 4 pixels
+					return OP_SCL;
+				case 0x00FD:
+					// 00FD EXIT: end the program
+					return OP_EXIT;
+				case 0x00FE:
+					// 00FE LOW: show the CHIP-8 screen
+					return OP_LOW;
+				case 0x00FF:
+					// 00FF HIGH: show the hi-res screen
+					return OP_HIGH;
 			}
 			break;
 		case 0x1:
 			// 1nnn JP: PC = nnn
-			JP(i);
-			return;
+			return OP_JP;
 		case 0x2:
 			// 2nnn CALL: push PC on stack, set PC to nnn
-			CALL(i);
-			return;
+			return OP_CALL;
 		case 0x3:
 			// 3xkk SE: skip next instruction if Vx = kk
-			SE(i);
-			return;
+			return OP_SE;
 		case 0x4:
 			// 4xkk SNEI: skip next instruction if Vx != kk
-			SNEI(i);
-			return;
+			return OP_SNEI;
 		case 0x5:
 			// Least Significant Nibble must be 0
 			if (!lsn) {
 				// 5xy0 SR: skip next instruction if Vx = Vy
-				SR(i);
-				return;
+				return OP_SR;
 			}
 			break;
 		case 0x6:
 			// 6xkk LDB: load Vx with kk
-			LDB(i);
-			return;
+			return OP_LDB;
 		case 0x7:
 			// 7xkk ADDI: Vx += kk
-			ADDI(i);
-			return;
+			return OP_ADDI;
 		case 0x8:
 			switch (lsn) {
 				case 0x0:
 					// 8xy0 LDR: load Vy into Vx
-					LDR(i);
-					return;
+					return OP_LDR;
 				case 0x1:
 					// 8xy1 OR: Vx |= Vy
-					OR(i);
-					return;
+					return OP_OR;
 				case 0x2:
 					// 8xy2 AND: Vx &= Vy
-					AND(i);
-					return;
+					return OP_AND;
 				case 0x3:
 					// 8xy3 XOR: Vx ^= Vy
-					XOR(i);
-					return;
+					return OP_XOR;
 				case 0x4:
 					// 8xy4 ADD: Vx += Vy; VF = 1 if overflow; VF = 0 otherwise
-					ADD(i);
-					return;
+					return OP_ADD;
 				case 0x5:
 					// 8xy5 SUB: Vx -= Vy; VF = 1 if Vx > Vy; VF = 0 otherwise
-					SUB(i);
-					return;
+					return OP_SUB;
 				case 0x6:
 					// 8xy6 SHR: Vx >>= 1; VF = Least Significant Bit of Vx
-					SHR(i);
-					return;
+					return OP_SHR;
 				case 0x7:
 					/*
 					 * 8xy7 SUBN: Vx = Vy - Vx; VF = 1 if Vy > Vx; VF = 0
 					 * otherwise
 					 */
-					SUBN(i);
-					return;
+					return OP_SUBN;
 				case 0xE:
 					// 8xyE SHL: Vx <<= 1; VF = Most Significant Bit of Vx
-					SHL(i);
-					return;
+					return OP_SHL;
 			}
 			break;
 		case 0x9:
 			// Least Significant Nibble must be 0
 			if (!lsn) {
 				// 9xy0 SNE: skip next instruction if Vx != Vy
-				SNE(i);
-				return;
+				return OP_SNE;
 			}
 			break;
 		case 0xA:
 			// Annn LDI: I = nnn
-			LDI(i);
-			return;
+			return OP_LDI;
 		case 0xB:
 			// Bnnn JPR: PC = nnn + V0
-			JPR(i);
-			return;
+			return OP_JPR;
 		case 0xC:
 			/*
 			 * Cxkk RND: generate random number from 0 to 255, AND with kk;
 			 * store in Vx
 			 */
-			RND(i);
-			return;
+			return OP_RND;
 		case 0xD:
+			if (!lsn) {
+				/*
+				 * Dxy0 DRWX: draw 16 x 16 sprite to the screen at memory
+				 * address I at (Vx, Vy); set VF = collision
+				 */
+				return OP_DRWX;
+			}
 			/*
 			 * Dxyn DRW: draw n-byte sprite to the screen at memory address I at
-			 * (Vx, Vy); set VF = collision. Draw flag is set to 1 to signal to
-			 * the run method to refresh the screen
+			 * (Vx, Vy); set VF = collision
 			 */
-			DRW(i);
-			draw = 1;
-			return;
+			return OP_DRW;
 		case 0xE:
 			if (BYTE(i) == 0x9E) {
 				/*
 				 * Ex9E SKP: skip next instruction if CHIP-8 input key with the
 				 * value of Vx is pressed
 				 */
-				SKP(i);
-				return;
+				return OP_SKP;
 			}
 			if (BYTE(i) == 0xA1) {
 				/*
 				 * ExA1 SKNP: skip next instruction if CHIP-8 input key with the
 				 * value of Vx is not pressed
 				 */
-				SKNP(i);
-				return;
+				return OP_SKNP;
 			}
 			break;
 		case 0xF:
 			switch (BYTE(i)) {
 				case 0x07:
 					// Fx07 LDD: Vx = delay_timer
-					LDD(i);
-					return;
+					return OP_LDD;
 				case 0x0A:
 					/*
 					 * Fx0A LDK: wait for a CHIP-8 input key press, store the
 					 * value of the key (0x0 - 0xF) in Vx
 					 */
-					LDK(i);
-					return;
+					return OP_LDK;
 				case 0x15:
 					// Fx15 STD: delay_timer = Vx
-					STD(i);
-					return;
+					return OP_STD;
 				case 0x18:
 					// Fx18 STS: sound_timer = Vx
-					STS(i);
-					return;
+					return OP_STS;
 				case 0x1E:
 					// Fx1E IINC: I += Vx
-					IINC(i);
-					return;
+					return OP_IINC;
 				case 0x29:
 					// Fx29 LDF: I = location of sprite for value in Vx
-					LDF(i);
-					return;
+					return OP_LDF;
+				case 0x30:
+					// Fx30 LDHF: I = location of big sprite for value in Vx
+					return OP_LDHF;
 				case 0x33:
 					/*
 					 * Fx33 BCD: store Binary Coded Decimal of value in Vx
 					 * starting at memory address I for hundreds place, I + 1
 					 * for tens, I + 2 for ones
 					 */
-					BCD(i);
-					return;
+					return OP_BCD;
 				case 0x55:
 					/*
 					 * Fx55 STA: store values in registers V0 - Vx in memory,
 					 * starting at address I
 					 */
-					STA(i);
-					return;
+					return OP_STA;
 				case 0x65:
 					/*
 					 * Fx65 LDA: load values for registers V0 - Vx from memory,
 					 * starting at address I
 					 */
-					LDA(i);
-					return;
+					return OP_LDA;
+				case 0x75:
+					// Fx75 STR: store V0 - Vx in the RPL user flags
+					return OP_STR;
+				case 0x85:
+					// Fx85 LDRF: load V0 - Vx from the RPL user flags
+					return OP_LDRF;
 				break;
 			}
 	}
-	printf("Unknown instruction at PC = 0x%04X\n0x%04X", PC - 2, i);
-	exit(EXIT_FAILURE);
+	return OP_UNKNOWN;
 }
 
-void _decrement_timers()
+void build_decode_table()
 {
-    if (delay_timer > 0) {
-        delay_timer--;
-    }
-    if (sound_timer > 0) {
-    	if (sound_timer == 1) {
-    		printf("\a");
-    	}
-        sound_timer--;
-    }
+	static u_int8_t built = 0;
+	u_int32_t i;
+
+	if (built) {
+		return;
+	}
+	for (i = 0; i <= 0xFFFF; i++) {
+		decode_table[i] = decode(i);
+	}
+	built = 1;
 }
 
-void _set_keys()
+void predecode(instruction i, decoded* d)
 {
-	int i;
-    u_int8_t* pressed = SDL_GetKeyState(NULL);
-
-    if (pressed[SDLK_ESCAPE]) {
-        exit(EXIT_SUCCESS);
-    }
-    for (i = 0; i < NUM_KEYS; i++) {
-    	keys[i] = pressed[emulator_keys[i]];
-    }
+#ifdef SWITCH_DISPATCH
+	d->op = decode(i);
+#else
+	d->op = decode_table[i];
+#endif
+	d->x = VX(i);
+	d->y = VY(i);
+	d->n = LSN(i);
+	d->kk = BYTE(i);
+	d->nnn = ADDR(i);
 }
 
-void refresh_screen()
+void execute(chip8* c, instruction i)
 {
-	int x, y;
-	SDL_Surface* emulator_screen = SDL_GetVideoSurface();
+	decoded d;
+
+	predecode(i, &d);
+	TRACE_RECORD(c, c->PC - 2, &d);
+	PROFILE_RECORD(c, c->PC - 2, &d);
+	c->handlers[d.op](c, &d);
+}
 
-	/* Secure surface to access pixels */
-	SDL_LockSurface(emulator_screen);
-	Uint32* emulator_pixels = (Uint32*) emulator_screen->pixels;
+int set_engine(chip8* c, u_int8_t engine)
+{
+	if (engine == ENGINE_CACHE && !c->cache) {
+		c->cache = malloc(SIZE_MEM * sizeof(decoded));
+		if (!c->cache) {
+			return -1;
+		}
+		flush_cache(c);
+	}
+	if (engine == ENGINE_BLOCK && alloc_blocks(c)) {
+		return -1;
+	}
+	c->engine = engine;
+	return 0;
+}
 
-	/* Clear emulator screen */
-	memset(emulator_pixels, 0, EMU_W * EMU_H);
+void flush_cache(chip8* c)
+{
+	address a;
 
-	/* Redraw emulator screen after DRW updates the CHIP-8 screen */
-	for (x = 0; x < EMU_W; x++) {
-		for (y = 0; y < EMU_H; y++) {
-			emulator_pixels[x + y * EMU_W]
-				= screen[x / 10 + (y / 10) * WIDTH] ? BLACK : WHITE;
+	if (c->cache) {
+		for (a = 0; a < SIZE_MEM; a++) {
+			c->cache[a].op = OP_NONE;
 		}
 	}
+	flush_blocks(c);
+}
 
-	/* Release surface */
-	SDL_UnlockSurface(emulator_screen);
-	SDL_Flip(emulator_screen);
-	SDL_Delay(10);
+void release(chip8* c)
+{
+	free(c->cache);
+	free(c->blocks);
+	c->cache = NULL;
+	c->blocks = NULL;
+	c->engine = ENGINE_INTERP;
+}
+
+void seed_rng(chip8* c, u_int32_t seed)
+{
+	/* Scramble the seed so that nearby seeds start far apart */
+	seed = (seed ^ (seed >> 16)) * 0x45D9F3B;
+	seed = (seed ^ (seed >> 16)) * 0x45D9F3B;
+	seed ^= seed >> 16;
+
+	/* xorshift never leaves the all-zero state */
+	c->rng = seed ? seed : DEFAULT_SEED;
 }
 
-void run()
+void set_key_mask(chip8* c, u_int16_t mask)
 {
 	int i;
-	SDL_Event e;
 
-	/* Initialize emulator screen */
-	SDL_Init(SDL_INIT_EVERYTHING);
-	SDL_SetVideoMode(EMU_W, EMU_H, BPP, SDL_HWSURFACE | SDL_DOUBLEBUF);
+	for (i = 0; i < NUM_KEYS; i++) {
+		c->keys[i] = (mask >> i) & 1;
+	}
+	c->idle = 0;
+}
 
-	for (;;) {
-		if (SDL_PollEvent(&e)) {
-			continue;
-		}
-		for (i = 0; i < 20; i++) {
-			_set_keys();
-			execute(fetch());
-			if (draw) {
-				draw = 0;
-				refresh_screen();
-			}
-		}
-		_decrement_timers();
+void _decrement_timers(chip8* c)
+{
+    c->idle = 0;
+    if (c->delay_timer > 0) {
+        c->delay_timer--;
+    }
+    if (c->sound_timer > 0) {
+        c->sound_timer--;
+    }
+}
+
+u_int32_t run_cycles(chip8* c, u_int32_t n)
+{
+	if (c->engine == ENGINE_CACHE) {
+		return quirk_profiles[c->quirks]->run_cached(c, n);
 	}
+	if (c->engine == ENGINE_BLOCK) {
+		return run_blocks(c, n);
+	}
+	return quirk_profiles[c->quirks]->run_interp(c, n);
+}
+
+void print_halt(const chip8* c)
+{
+	switch (c->halt) {
+		case HALT_OVERFLOW:
+			printf("Stack overflow\n");
+			break;
+		case HALT_UNDERFLOW:
+			printf("Empty stack\n");
+			break;
+		case HALT_UNKNOWN:
+			printf("Unknown instruction at PC = 0x%04X\n0x%04X\n", c->PC - 2,
+				INSTR(c->RAM[MEM(c->PC - 2)], c->RAM[MEM(c->PC - 1)]));
+			break;
+		case HALT_EXIT:
+			printf("Program exited\n");
+			break;
+	}
+}
+
+int load_rom(chip8* c, const char* path)
+{
+	const rom_image* r = open_rom(path);
+
+	if (!r) {
+		return -1;
+	}
+	copy_rom(c, r);
+	return 0;
 }
 
-void load_source()
+void load_source(chip8* c)
 {
 	char rom_name[50];
-	FILE* rom;
 
 	printf("\nEnter name of the CHIP-8 ROM (ending with .rom) to emulate: ");
-	if (!scanf("%s", rom_name)) {
+	if (scanf("%49s", rom_name) != 1) {
 		printf("Error reading STDIN\n");
 		fflush(stdin);
 		exit(EXIT_FAILURE);
 	}
-	rom = fopen(rom_name, "rb");
-	if (!rom)  {
-		printf("ROM not found\n");
+	if (load_rom(c, rom_name)) {
 		fflush(stdin);
 		exit(EXIT_FAILURE);
 	}
-	/*
-	 * Read into RAM starting at 0x200, 1 byte at a time, maximum number of
-	 * elements is 0xCA0 which is the number of bytes between 0x200 and where
-	 * the stack begins
-	 */
-	if (!fread(RAM + 0x200, 1, 0xCA0, rom)) {
-		printf("Error reading ROM\n");
-		exit(EXIT_FAILURE);
-	}
 }
 
-void print_stack()
+void print_stack(chip8* c)
 {
 	u_int8_t found = 0;
+	address cp;
 
 	/* check one memory address above the stack to see if it's full */
 	printf("|         |");
-	address* cp = (address*) &RAM[STACK_UP - sizeof(address)];
-	if (cp == sp) {
+	cp = STACK_UP - sizeof(address);
+	if (cp == c->sp) {
 		found = 1;
 		printf(" <- sp");
 	}
 	printf("\n");
 	/* print stack memory addresses */
-	for (cp += 1; cp <= (address*) &RAM[STACK_LOW]; cp++) {
-		printf("| 0x%04X |", *cp);
-		if (!found && cp == sp) {
+	for (cp += sizeof(address); cp <= STACK_LOW; cp += sizeof(address)) {
+		printf("| 0x%04X |", INSTR(c->RAM[cp], c->RAM[cp + 1]));
+		if (!found && cp == c->sp) {
 			found = 1;
 			printf(" <- sp");
 		}
@@ -380,10 +482,302 @@ void print_stack()
 	}
 }
 
-int main()
+/*
+ * Write the profile of machine c to the file at path using dump. Returns 0 on
+ * success, or -1 after printing the error.
+ */
+static int write_profile(const chip8* c, const char* path,
+	void (*dump)(const chip8*, FILE*))
 {
-	initialize();
-	load_source();
-	run();
-	return 0;
+	FILE* f = fopen(path, "w");
+
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+	dump(c, f);
+	return fclose(f) ? -1 : 0;
+}
+
+/*
+ * Run the job list at jobs_path as a batch and write the results to the file
+ * at results_path, or stdout if NULL. Returns the exit status of the emulator.
+ */
+static int batch_main(const char* jobs_path, const char* results_path,
+	u_int32_t seed, const headless_config* config, u_int8_t engine,
+	u_int8_t quirks, const char* translations, unsigned threads)
+{
+	batch_job* jobs;
+	batch_result* results;
+	unsigned long count;
+	FILE* f = stdout;
+
+	if (load_jobs(jobs_path, seed, &jobs, &count)) {
+		return EXIT_FAILURE;
+	}
+	results = malloc((count ? count : 1) * sizeof(batch_result));
+	if (!results || run_batch(jobs, count, config, engine, quirks,
+		translations, threads, results)) {
+		printf("Not enough memory for the batch\n");
+		free(jobs);
+		free(results);
+		return EXIT_FAILURE;
+	}
+	if (results_path && !(f = fopen(results_path, "w"))) {
+		perror(results_path);
+	} else {
+		write_results(f, jobs, results, count);
+		if (f != stdout) {
+			fclose(f);
+		}
+	}
+	free(jobs);
+	free(results);
+	return f ? 0 : EXIT_FAILURE;
+}
+
+/*
+ * Print how to invoke the emulator.
+ */
+static void usage(const char* name)
+{
+	printf("Usage: %s [-e engine] [-q quirks] [-i ips] [-m speed] [-t] [-u]"
+		" [-v] [-G] [-H] [-c cycles] [-f frames] [-k script] [-r state]"
+		" [-s state] [-S seed] [-b jobs] [-j threads] [-o results]"
+		" [-B corpus] [-p profile] [-F folded] [-T dir] [-L port] [rom]\n",
+		name);
+	printf("  rom        ROM to run (default: prompt for its name)\n");
+	printf("  -e engine  interp (default), cache, or block\n");
+	printf("  -q quirks  default (default), vip, schip, or auto to guess"
+		" from the ROM\n");
+	printf("  -i ips     instructions per second (default %u)\n", DEFAULT_IPS);
+	printf("  -m speed   run speed times faster than real time\n");
+	printf("  -t         start in turbo mode; Tab toggles it\n");
+	printf("  -u         apply key presses at the time within a frame they"
+		" happened\n");
+	printf("  -v         pace frames by vertical sync\n");
+	printf("  -G         scale the screen on the GPU in a resizable window"
+		" (OPENGL builds)\n");
+	printf("  -H         run headless, without a display\n");
+	printf("  -c cycles  headless: stop after this many instructions\n");
+	printf("  -f frames  headless: stop after this many frames\n");
+	printf("  -k script  headless: read key presses from an input script\n");
+	printf("  -r state   resume from a saved state instead of the ROM's start\n");
+	printf("  -s state   headless: save the state when the run ends\n");
+	printf("  -S seed    seed random numbers, or time to seed them from the"
+		" clock (default: %#x)\n", DEFAULT_SEED);
+	printf("  -b jobs    run the job list headless across all cores\n");
+	printf("  -j threads batch: number of worker threads (default: cores)\n");
+	printf("  -o results batch: write results to this file (default: stdout)\n");
+	printf("  -B corpus  benchmark every engine on the ROMs of a job list\n");
+	printf("  -p profile headless: write the execution profile histogram\n");
+	printf("  -F folded  headless: write the profile as folded stacks\n");
+	printf("  -T dir     cache translated blocks in dir across runs\n");
+	printf("  -L port    stream the screen to viewers connecting to port\n");
+}
+
+int main(int argc, char** argv)
+{
+	chip8 c;
+	int opt;
+	int status;
+	int headless = 0;
+	const char* script_path = NULL;
+	const char* restore_path = NULL;
+	const char* save_path = NULL;
+	const char* jobs_path = NULL;
+	const char* results_path = NULL;
+	const char* corpus_path = NULL;
+	const char* profile_path = NULL;
+	const char* folded_path = NULL;
+	const char* translations = NULL;
+	unsigned threads = 0;
+	input_script script = { NULL, 0 };
+	stream_config stream = { 0, 0 };
+	headless_config config = { 0, 0, NULL, 0 };
+	headless_result result;
+	u_int8_t engine = ENGINE_INTERP;
+	int quirks = QUIRKS_DEFAULT;
+	u_int32_t seed = DEFAULT_SEED;
+#ifndef NO_SDL
+	frontend_config frontend = { 0 };
+#endif
+
+	while ((opt = getopt(argc, argv, "e:q:i:m:tuvGHc:f:k:r:s:S:b:j:o:B:p:F:T:L:")) != -1) {
+		switch (opt) {
+			case 'i':
+				config.ips = strtoul(optarg, NULL, 0);
+				stream.ips = config.ips;
+#ifndef NO_SDL
+				frontend.ips = config.ips;
+#endif
+				break;
+#ifndef NO_SDL
+			case 'm':
+				frontend.speed = strtod(optarg, NULL);
+				if (frontend.speed <= 0) {
+					usage(argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 't':
+				frontend.turbo = 1;
+				break;
+			case 'u':
+				frontend.subframe = 1;
+				break;
+			case 'v':
+				frontend.vsync = 1;
+				break;
+#ifdef OPENGL
+			case 'G':
+				frontend.opengl = 1;
+				break;
+#endif
+#endif
+			case 'e':
+				if (!strcmp(optarg, "interp")) {
+					engine = ENGINE_INTERP;
+				} else if (!strcmp(optarg, "cache")) {
+					engine = ENGINE_CACHE;
+				} else if (!strcmp(optarg, "block")) {
+					engine = ENGINE_BLOCK;
+				} else {
+					usage(argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'q':
+				quirks = find_quirks(optarg);
+				if (quirks < 0) {
+					usage(argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'H':
+				headless = 1;
+				break;
+			case 'c':
+				config.cycles = strtoul(optarg, NULL, 0);
+				break;
+			case 'f':
+				config.frames = strtoul(optarg, NULL, 0);
+				break;
+			case 'k':
+				script_path = optarg;
+				break;
+			case 'r':
+				restore_path = optarg;
+				break;
+			case 's':
+				save_path = optarg;
+				break;
+			case 'S':
+				/* Runs repeat exactly unless the clock is asked for */
+				seed = strcmp(optarg, "time") ? strtoul(optarg, NULL, 0)
+					: time(NULL);
+				break;
+			case 'b':
+				jobs_path = optarg;
+				break;
+			case 'j':
+				threads = strtoul(optarg, NULL, 0);
+				break;
+			case 'o':
+				results_path = optarg;
+				break;
+			case 'B':
+				corpus_path = optarg;
+				break;
+			case 'p':
+				profile_path = optarg;
+				break;
+			case 'F':
+				folded_path = optarg;
+				break;
+			case 'T':
+				translations = optarg;
+				break;
+			case 'L':
+				stream.port = strtoul(optarg, NULL, 0);
+				if (!stream.port) {
+					usage(argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+			default:
+				usage(argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+#ifdef NO_SDL
+	/* Without SDL there is no display to run on */
+	headless = 1;
+#endif
+
+	if (corpus_path) {
+		return run_benchmark(corpus_path, &config, quirks, stdout)
+			? EXIT_FAILURE : 0;
+	}
+	if (jobs_path) {
+		return batch_main(jobs_path, results_path, seed, &config, engine,
+			quirks, translations, threads);
+	}
+
+	initialize(&c);
+	seed_rng(&c, seed);
+	if (optind < argc) {
+		if (load_rom(&c, argv[optind])) {
+			return EXIT_FAILURE;
+		}
+	} else {
+		load_source(&c);
+	}
+	set_quirks(&c, quirks);
+	if (restore_path && restore_file(&c, restore_path)) {
+		return EXIT_FAILURE;
+	}
+	if (set_engine(&c, engine)
+		|| (translations && warm_translation(&c, translations))) {
+		printf("Not enough memory for the execution engine\n");
+		return EXIT_FAILURE;
+	}
+	if (stream.port) {
+		return serve_stream(&c, &stream) ? EXIT_FAILURE : 0;
+	}
+	if (!headless) {
+#ifndef NO_SDL
+		run(&c, &frontend);
+#endif
+		return 0;
+	}
+
+	if (script_path) {
+		if (load_script(script_path, &script)) {
+			return EXIT_FAILURE;
+		}
+		config.input = &script;
+	}
+	run_headless(&c, &config, &result);
+	printf("cycles=%lu frames=%lu\n", result.cycles, result.frames);
+	if (result.halt) {
+		print_halt(&c);
+	}
+	/* A program which exited itself ran fine */
+	status = result.halt && result.halt != HALT_EXIT ? EXIT_FAILURE : 0;
+	if (status) {
+		dump_trace(&c, stderr);
+	}
+	if (profile_path && write_profile(&c, profile_path, dump_profile)) {
+		status = EXIT_FAILURE;
+	}
+	if (folded_path && write_profile(&c, folded_path, dump_folded)) {
+		status = EXIT_FAILURE;
+	}
+	if (save_path && save_file(&c, save_path)) {
+		status = EXIT_FAILURE;
+	}
+	free_script(&script);
+	release(&c);
+	return status;
 }
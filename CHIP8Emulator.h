@@ -35,34 +35,39 @@
 /* INCLUDE */
 #include "InstructionSet.h"
 
-/* Signal to refresh the screen after it's been edited */
-u_int8_t draw;
-
-/* Emulator keys. A normal CHIP-8 keyboard would be in the following order:
- *     1 2 3 C
- *     4 5 6 D
- *     7 8 9 E
- *     A 0 B F
- *
- * This emulator has these keys arranged in the following order:
- *     1 2 3 4
- *     Q W E R
- *     A S D F
- *     Z X C V
+/*
+ * Number of instructions executed between two decrements of the delay and sound
+ * timers. One such group of instructions makes up a frame.
  */
-uint8_t emulator_keys[NUM_REGS];
+#define CYCLES_PER_FRAME 20
+
+/* Frames per second: the rate at which the delay and sound timers count down */
+#define FRAME_RATE 60
+
+/* Seed of the random number generator unless one is given */
+#define DEFAULT_SEED 0x2545F491
+
+/* Execution engines a machine can run on */
+#define ENGINE_INTERP 0 // fetch, decode, and execute every instruction
+#define ENGINE_CACHE  1 // execute from the predecoded instruction cache
+#define ENGINE_BLOCK  2 // run translated basic blocks, see BlockEngine.h
 
 /* PROTOTYPES */
 /*
- * Initialize all necessary values to their appropriate starting values.
+ * Initialize all necessary values of machine c to their appropriate starting
+ * values.
  *
  * All registers in v are set to zero, the screen is zeroed out, all keys are
  * set to zero (not pressed), RAM (including the stack) is cleared, the font set
- * is loaded into RAM, the random number generator is seeded, PC is initialized
- * to 0x200, I is set to zero, and the stack pointer is initialized to point to
- * the lower bound of the stack (0xEBE).
+ * is loaded into RAM, the random number generator is seeded with DEFAULT_SEED,
+ * PC is initialized to 0x200, I is set to zero, and the stack pointer is
+ * initialized to point to the lower bound of the stack (0xEBE).
+ *
+ * The machine is set to run on ENGINE_INTERP with QUIRKS_DEFAULT. If it was
+ * running on another engine, release must be called first to free the memory
+ * that engine holds.
  */
-void initialize();
+void initialize(chip8* c);
 
 /*
  * Fetch instruction located at address PC.
@@ -72,17 +77,23 @@ void initialize();
  * the complete instruction. PC must then be incremented by 2 to skip the second
  * half of the instruction fetched.
  */
-instruction fetch();
+instruction fetch(chip8* c);
 
 /*
- * Decode and execute the instruction returned by fetch.
+ * Decoding of every possible instruction, indexed by the instruction itself.
+ * Holds the OP_ value of each instruction once build_decode_table is called.
+ */
+extern u_int8_t decode_table[0x10000];
+
+/*
+ * Decode an instruction, returning which operation (defined in
+ * InstructionSet.h) it performs.
  *
  * The process of decoding (determining what kind of operation is required,
  * which registers are used, which constants are used) an instruction usually
  * involves indexing into a microcontroller/ROM unit. This process is emulated
- * by having the decode method which determines what operation (defined in
- * InstructionSet.h) the current instruction performs via switch statement which
- * is then executed.
+ * by a switch statement which determines what operation the current
+ * instruction performs.
  *
  * Unlike other instruction sets, the CHIP-8's does not feature instructions
  * with unique op-codes; rather the entire instruction can be thought of as the
@@ -92,63 +103,121 @@ instruction fetch();
  * within that switch is handled either by an if statement or another switch in
  * order to determine the instruction's operation.
  *
- * If the instruction being decoded is not a member of the instruction set, the
- * decode method will display an error message and end the emulation.
+ * If the instruction is not a member of the instruction set, OP_UNKNOWN is
+ * returned.
  */
-void execute(instruction i);
+u_int8_t decode(instruction i);
+
+/*
+ * Fill decode_table by decoding every one of the 65536 possible instructions.
+ *
+ * The table is shared by all machines; only the first call does any work.
+ */
+void build_decode_table();
+
+/*
+ * Decode instruction i into d: look up its operation and unpack its operands.
+ */
+void predecode(instruction i, decoded* d);
+
+/*
+ * Decode and execute the instruction returned by fetch.
+ *
+ * Because every instruction is 16 bits, decoding is done ahead of time for all
+ * of them: the instruction indexes decode_table to find its operation, and the
+ * method for that operation is called through the handlers of the machine's
+ * quirk profile. This replaces the chain of branches the switch in decode
+ * needs with two table lookups. When compiled with SWITCH_DISPATCH defined,
+ * decode is called on every instruction instead so that the two approaches
+ * can be compared.
+ *
+ * If the instruction being executed is not a member of the instruction set, the
+ * machine halts with HALT_UNKNOWN.
+ */
+void execute(chip8* c, instruction i);
+
+/*
+ * Select the execution engine of machine c, one of the ENGINE_ values.
+ *
+ * ENGINE_CACHE keeps a predecoded copy of every instruction it reaches, indexed
+ * by its address, so instructions in loops are decoded only once. Writing to
+ * memory discards the copies of any instructions written over. The cache is
+ * allocated the first time this engine is selected; returns -1 if there isn't
+ * enough memory for it, 0 otherwise.
+ *
+ * ENGINE_BLOCK translates whole basic blocks instead, as described in
+ * BlockEngine.h, and is allocated the same way.
+ */
+int set_engine(chip8* c, u_int8_t engine);
+
+/*
+ * Discard every predecoded instruction and translated block of machine c. Must
+ * be called whenever memory is changed other than through write_mem, such as
+ * loading a ROM.
+ */
+void flush_cache(chip8* c);
+
+/*
+ * Free the memory held by the execution engine of machine c and return it to
+ * ENGINE_INTERP.
+ */
+void release(chip8* c);
+
+/*
+ * Seed the random number generator of machine c with seed.
+ *
+ * Machines seeded with the same seed generate the same random numbers. Any
+ * seed may be given, including 0; nearby seeds give unrelated numbers.
+ */
+void seed_rng(chip8* c, u_int32_t seed);
+
+/*
+ * Set the keys of machine c to those held down by mask, bit k for key k. The
+ * machine is no longer idle.
+ */
+void set_key_mask(chip8* c, u_int16_t mask);
 
 /*
  * Decrement the delay and sound counters by 1 if greater than 0.
  *
  * Whenever greater than 0, both of these timers should decrease by 1 at a rate
  * of 60 Hz. For the sound timer specifically, whenever its value is greater
- * than 0, a sound should be made. In this emulator, printf("\a") is used to
- * achieve this.
+ * than 0, a sound should be made. The core itself makes no sound; a front end
+ * which has a speaker reads sound_timer after each decrement (see Audio.h),
+ * so running headless costs nothing.
+ *
+ * The machine is no longer idle.
  */
-void _decrement_timers();
+void _decrement_timers(chip8* c);
 
 /*
- * Helper method to set which of the CHIP-8 keys are pressed (1) and which are
- * not (0) based on which of the emulated (keyboard) keys are pressed.
+ * Fetch and execute up to n instructions on machine c using its execution
+ * engine, through the run loop compiled for its quirk profile.
  *
- * During normal execution, if a keyboard on the machine running this emulator
- * is pressed, then this method will update the appropriate value in the keys
- * pointer to reflect this change.
+ * Execution stops early if the machine halts or becomes idle; an idle machine
+ * executes nothing until its timers are decremented or its keys change, since
+ * it would only spin in place until then. Returns the number of instructions
+ * which were executed.
  */
-void _set_keys();
+u_int32_t run_cycles(chip8* c, u_int32_t n);
 
 /*
- * Clears the emulated CHIP-8 screen and draw how it should appear after a call
- * to the DRW instruction.
+ * Print why machine c halted.
  *
- * Whenever the DRW instruction is executed, the draw flag is set to 1, and in
- * the run method, the pixels on the screen will be updated. It is possible to
- * write this method in such a way that it only updates the pixels on the
- * emulator screen which were affected by the DRW instruction instead of this
- * implementation which clears and redraws the entire screen, but since ROMs
- * written in the CHIP-8 language often draw and clear sprites on their own,
- * the flickering effect seen when running a Pong game on this emulator is
- * inevitable unless rewriting the ROM.
+ * For an unknown instruction, the address it was found at and the instruction
+ * itself are printed.
  */
-void refresh_screen();
+void print_halt(const chip8* c);
 
 /*
- * Runs program in RAM.
- *
- * While there are instructions without error, the emulator runs whatever CHIP-8
- * source is located in its RAM. This method will first initiate the emulator
- * screen, then it will continually perform the fetch, decode, and execute cycle
- * while there are instructions to execute.
- *
- * This method will also update the CHIP-8 keyboard values using the emulator
- * keys. For every key on the emulator keyboard that is pressed, the
- * corresponding CHIP-8 key in the keys pointer will also be marked as pressed.
- * Any non-pressed emulator key will be marked as not pressed.
+ * Load the CHIP-8 instructions in the file at path into the RAM of machine c,
+ * starting at 0x200. The file is read only the first time it is loaded in the
+ * process; later loads copy it from the ROM registry (see RomCache.h).
  *
- * Delay and sound timers will also be decremented at the end of one of the
- * cycles.
+ * Returns 0 on success. If the file can't be opened or read, an error message
+ * is printed and -1 is returned.
  */
-void run();
+int load_rom(chip8* c, const char* path);
 
 /*
  * Loads the CHIP-8 instructions located in a chosen file into the emulator's
@@ -160,7 +229,7 @@ void run();
  * name. If a file with this name exists, the emulator loads and executes it;
  * otherwise, an error message will display, and the program will end.
  */
-void load_source();
+void load_source(chip8* c);
 
 /*
  * Print the contents of the stack.
@@ -169,6 +238,6 @@ void load_source();
  * stack pointer is located from memory addresses 0xEBE to 0xEA0 - 1 to see if
  * the stack is full.
  */
-void print_stack();
+void print_stack(chip8* c);
 
 #endif
@@ -0,0 +1,87 @@
+#include <string.h>
+#include "Display.h"
+
+void expand_rows(const u_int64_t* screen, u_int64_t rows, u_int32_t* pixels,
+	int pitch)
+{
+	int x, y, k;
+	u_int32_t color;
+	u_int32_t* line;
+	u_int32_t* p;
+
+	for (y = 0; y < HEIGHT; y++) {
+		if (!(rows & (1ULL << y))) {
+			continue;
+		}
+		line = pixels + y * SCALE * pitch;
+		p = line;
+		for (x = 0; x < WIDTH; x++) {
+			color = PIXEL(screen[y], x) ? BLACK : WHITE;
+			for (k = 0; k < SCALE; k++) {
+				*p++ = color;
+			}
+		}
+		for (k = 1; k < SCALE; k++) {
+			memcpy(line + k * pitch, line, EMU_W * sizeof(u_int32_t));
+		}
+	}
+}
+
+void expand_hires_rows(const u_int64_t (*screen)[HIRES_WORDS], u_int64_t rows,
+	u_int32_t* pixels, int pitch)
+{
+	int x, y, k;
+	u_int32_t color;
+	u_int32_t* line;
+	u_int32_t* p;
+
+	for (y = 0; y < HIRES_HEIGHT; y++) {
+		if (!(rows & (1ULL << y))) {
+			continue;
+		}
+		line = pixels + y * HIRES_SCALE * pitch;
+		p = line;
+		for (x = 0; x < HIRES_WIDTH; x++) {
+			color = PIXEL(screen[y][x / 64], x % 64) ? BLACK : WHITE;
+			for (k = 0; k < HIRES_SCALE; k++) {
+				*p++ = color;
+			}
+		}
+		for (k = 1; k < HIRES_SCALE; k++) {
+			memcpy(line + k * pitch, line, EMU_W * sizeof(u_int32_t));
+		}
+	}
+}
+
+void unpack_rows(const u_int64_t* screen, u_int64_t rows, u_int8_t* texels)
+{
+	int x, y;
+	u_int8_t* p;
+
+	for (y = 0; y < HEIGHT; y++) {
+		if (!(rows & (1ULL << y))) {
+			continue;
+		}
+		p = texels + y * WIDTH;
+		for (x = 0; x < WIDTH; x++) {
+			*p++ = PIXEL(screen[y], x) ? TEXEL_ON : TEXEL_OFF;
+		}
+	}
+}
+
+void unpack_hires_rows(const u_int64_t (*screen)[HIRES_WORDS], u_int64_t rows,
+	u_int8_t* texels)
+{
+	int x, y;
+	u_int8_t* p;
+
+	for (y = 0; y < HIRES_HEIGHT; y++) {
+		if (!(rows & (1ULL << y))) {
+			continue;
+		}
+		p = texels + y * HIRES_WIDTH;
+		for (x = 0; x < HIRES_WIDTH; x++) {
+			*p++ = PIXEL(screen[y][x / 64], x % 64) ? TEXEL_ON : TEXEL_OFF;
+		}
+	}
+}
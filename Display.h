@@ -0,0 +1,61 @@
+/*
+ * Presentation of the CHIP-8 screen on a host display.
+ *
+ * The CHIP-8 screen is stored packed, one bit per pixel, while host displays
+ * hold one 32-bit value per pixel and are SCALE times larger on each axis
+ * (HIRES_SCALE for the hi-res screen of the SUPER-CHIP). The methods here
+ * convert only those rows of the screen which have changed since the screen
+ * was last presented: either expanded to the emulator screen on the CPU, or
+ * unpacked at native size, one byte per pixel, for a GPU to scale (see
+ * GLDisplay.h). They don't depend on SDL, so they can be used with any pixel
+ * buffer.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+/* INCLUDE */
+#include "InstructionSet.h"
+
+/* DEFINE */
+#define TEXEL_ON  0xFF // luminance of a pixel which is set
+#define TEXEL_OFF 0    // luminance of a pixel which is clear
+
+/* PROTOTYPES */
+/*
+ * Expand the rows of screen set in rows into pixels, an EMU_W x EMU_H buffer
+ * with pitch 32-bit values from the start of one line to the next.
+ *
+ * Each CHIP-8 row is expanded once into its first line of pixels, one span of
+ * SCALE equal values per CHIP-8 pixel, and that line is then copied to the
+ * remaining SCALE - 1 lines of the row.
+ */
+void expand_rows(const u_int64_t* screen, u_int64_t rows, u_int32_t* pixels,
+	int pitch);
+
+/*
+ * Expand the rows of the hi-res screen set in rows, given in order, into
+ * pixels as expand_rows does, HIRES_SCALE pixels per hi-res pixel.
+ */
+void expand_hires_rows(const u_int64_t (*screen)[HIRES_WORDS], u_int64_t rows,
+	u_int32_t* pixels, int pitch);
+
+/*
+ * Unpack the rows of screen set in rows into texels, a WIDTH x HEIGHT buffer
+ * of one luminance byte per pixel with no padding between lines.
+ */
+void unpack_rows(const u_int64_t* screen, u_int64_t rows, u_int8_t* texels);
+
+/*
+ * Unpack the rows of the hi-res screen set in rows, given in order, into
+ * texels, a HIRES_WIDTH x HIRES_HEIGHT buffer laid out as for unpack_rows.
+ */
+void unpack_hires_rows(const u_int64_t (*screen)[HIRES_WORDS], u_int64_t rows,
+	u_int8_t* texels);
+
+#endif
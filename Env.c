@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include "Env.h"
+#include "Quirks.h"
+#include "Scheduler.h"
+
+/*
+ * Read the score of instance i of e from its memory.
+ */
+static int32_t _score(const env* e, u_int32_t i)
+{
+	const chip8* c = &e->lanes->machines[i];
+	u_int32_t score = 0;
+	int b;
+
+	for (b = 0; b < e->config.score_bytes; b++) {
+		score = score << 8 | c->RAM[MEM(e->config.score[b])];
+	}
+	return (int32_t) score;
+}
+
+env* create_env(const env_config* config)
+{
+	env* e = calloc(1, sizeof(env));
+	chip8 c;
+
+	if (!e) {
+		printf("Not enough memory for the environment\n");
+		return NULL;
+	}
+	e->config = *config;
+	if (e->config.score_bytes > MAX_SCORE_BYTES) {
+		e->config.score_bytes = MAX_SCORE_BYTES;
+	}
+	e->cycles = (config->ips ? config->ips : DEFAULT_IPS) / FRAME_RATE;
+
+	initialize(&c);
+	if (load_rom(&c, config->rom)) {
+		free(e);
+		return NULL;
+	}
+	set_quirks(&c, config->quirks);
+	save_machine(&c, &e->image);
+	e->lanes = alloc_vector(config->instances);
+	e->scores = calloc(config->instances ? config->instances : 1,
+		sizeof(int32_t));
+	if (!e->lanes || !e->scores) {
+		printf("Not enough memory for the environment\n");
+		destroy_env(e);
+		return NULL;
+	}
+	vector_load(e->lanes, &c);
+	return e;
+}
+
+void destroy_env(env* e)
+{
+	if (e->lanes) {
+		free_vector(e->lanes);
+	}
+	free(e->scores);
+	free(e);
+}
+
+void reset_instance(env* e, u_int32_t i, u_int32_t seed)
+{
+	vector_reset(e->lanes, i, &e->image);
+	vector_seed(e->lanes, i, seed);
+	e->scores[i] = _score(e, i);
+}
+
+void reset_env(env* e, u_int32_t seed)
+{
+	u_int32_t i;
+
+	for (i = 0; i < e->config.instances; i++) {
+		reset_instance(e, i, seed + i);
+	}
+}
+
+void step_env(env* e, const u_int16_t* actions, u_int32_t frames,
+	int32_t* rewards, u_int8_t* done)
+{
+	u_int32_t i;
+	int32_t score;
+
+	for (i = 0; i < e->config.instances; i++) {
+		vector_keys(e->lanes, i, actions[i]);
+	}
+	while (frames--) {
+		vector_frame(e->lanes, e->cycles);
+	}
+	for (i = 0; i < e->config.instances; i++) {
+		score = _score(e, i);
+		if (rewards) {
+			rewards[i] = score - e->scores[i];
+		}
+		if (done) {
+			done[i] = e->lanes->halt[i] != HALT_NONE;
+		}
+		e->scores[i] = score;
+	}
+}
+
+const u_int64_t* env_screens(const env* e)
+{
+	return e->lanes->machines[0].screen;
+}
+
+size_t screen_stride()
+{
+	return sizeof(chip8);
+}
@@ -0,0 +1,106 @@
+/*
+ * Reinforcement learning environment around the CHIP-8 emulator.
+ *
+ * An environment runs a batch of instances of one ROM in lockstep (see
+ * VectorEnv.h) behind a reset and step interface, so that a single call
+ * advances every instance and the cost of the call is shared among them.
+ *
+ * The action of an instance is the mask of CHIP-8 keys it holds down for a
+ * step, bit k for key k. Its reward for a step is how much its score grew,
+ * where the score is a number the ROM keeps in memory: the bytes at the
+ * configured addresses read in order, most significant first. An instance is
+ * done once its machine halts; stepping it further does nothing until it is
+ * reset.
+ *
+ * Observations are not copied out: the screen of every instance is read
+ * where the instance keeps it, bit-packed as described in InstructionSet.h.
+ * The screens of all instances are found at the same stride from the first,
+ * so that they can be viewed as one array without copying.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef ENV_H_
+#define ENV_H_
+
+/* INCLUDE */
+#include <stddef.h>
+#include "VectorEnv.h"
+
+/* DEFINE */
+#define MAX_SCORE_BYTES 4 // most bytes of memory a score is read from
+
+/* TYPEDEFS */
+/* How to build an environment */
+typedef struct env_config {
+	const char* rom;     // ROM every instance runs
+	u_int32_t instances; // number of instances
+	u_int32_t ips;       // instructions per second, 0 for DEFAULT_IPS
+	address score[MAX_SCORE_BYTES]; // bytes of the score, most significant first
+	u_int8_t score_bytes; // number of bytes in score, 0 for no rewards
+	u_int8_t quirks;      // QUIRKS_ profile to run with, see Quirks.h
+} env_config;
+
+typedef struct env {
+	vector_env* lanes;   // instance i runs on lane i
+	save_state image;    // state of an instance right after the ROM loaded
+	env_config config;
+	u_int32_t cycles;    // instructions per frame
+	int32_t* scores;     // score of each instance when last stepped or reset
+} env;
+
+/* PROTOTYPES */
+/*
+ * Create the environment config describes, its instances not yet reset.
+ * Returns NULL after printing the error if the ROM can't be loaded or there
+ * isn't enough memory.
+ */
+env* create_env(const env_config* config);
+
+/*
+ * Free environment e.
+ */
+void destroy_env(env* e);
+
+/*
+ * Reset every instance of e to the start of the ROM, seeding instance i with
+ * seed + i.
+ */
+void reset_env(env* e, u_int32_t seed);
+
+/*
+ * Reset instance i of e to the start of the ROM, seeded with seed.
+ *
+ * Only the memory the instance wrote to since it was last reset is copied
+ * back, so resetting costs in proportion to what the last episode touched.
+ */
+void reset_instance(env* e, u_int32_t i, u_int32_t seed);
+
+/*
+ * Run frames frames on every instance of e which is not done, instance i
+ * holding down the keys in actions[i]. The reward of instance i is written to
+ * rewards[i] and whether it is done to done[i]; either may be NULL.
+ */
+void step_env(env* e, const u_int16_t* actions, u_int32_t frames,
+	int32_t* rewards, u_int8_t* done);
+
+/*
+ * Return the screen of instance 0 of e: HEIGHT rows of WIDTH pixels, one
+ * 64-bit word per row with the leftmost pixel in the most significant bit.
+ * The screen of instance i starts i * screen_stride() bytes further on.
+ *
+ * The screens are read in place and change with every step. They are the
+ * CHIP-8 screens only: a SUPER-CHIP program in hi-res mode draws elsewhere.
+ */
+const u_int64_t* env_screens(const env* e);
+
+/*
+ * Return the distance in bytes between the screens of two instances which
+ * follow one another.
+ */
+size_t screen_stride();
+
+#endif
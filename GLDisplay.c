@@ -0,0 +1,144 @@
+#if !defined(NO_SDL) && defined(OPENGL)
+#include <SDL/SDL.h>
+#include <SDL/SDL_opengl.h>
+#include "GLDisplay.h"
+#include "Display.h"
+
+/* Screen as last uploaded, kept to upload again whenever the context is lost */
+static u_int8_t _texels[HIRES_WIDTH * HIRES_HEIGHT];
+static u_int8_t _hires; // texture holds the hi-res screen
+static GLuint _texture;
+
+/*
+ * Create the screen texture at the size of the screen held in _texels, and
+ * upload every row of it.
+ */
+static void _create_texture(void)
+{
+	if (_hires) {
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, HIRES_WIDTH, HIRES_HEIGHT,
+			0, GL_LUMINANCE, GL_UNSIGNED_BYTE, _texels);
+	} else {
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, WIDTH, HEIGHT, 0,
+			GL_LUMINANCE, GL_UNSIGNED_BYTE, _texels);
+	}
+}
+
+/*
+ * Set the video mode to a w x h OpenGL window and set up the context for it:
+ * the screen texture with every row uploaded, and a viewport as large as fits
+ * the window at the aspect ratio of the screen. SDL may create a new context
+ * whenever the mode is set, so nothing made in the old one is relied on.
+ * Returns 0 on success, -1 if the mode couldn't be set.
+ */
+static int _set_mode(int w, int h)
+{
+	int vw = w;
+	int vh = h;
+
+	if (!SDL_SetVideoMode(w, h, 0, SDL_OPENGL | SDL_RESIZABLE)) {
+		return -1;
+	}
+	if (!_texture) {
+		glGenTextures(1, &_texture);
+	}
+	glBindTexture(GL_TEXTURE_2D, _texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	_create_texture();
+	glEnable(GL_TEXTURE_2D);
+	glClearColor(0, 0, 0, 1);
+
+	/* Border whichever axis is too long for the aspect ratio */
+	if ((long) w * HEIGHT > (long) h * WIDTH) {
+		vw = h * WIDTH / HEIGHT;
+	} else {
+		vh = w * HEIGHT / WIDTH;
+	}
+	glViewport((w - vw) / 2, (h - vh) / 2, vw, vh);
+	return 0;
+}
+
+/*
+ * Draw the screen texture over the whole viewport and swap buffers.
+ */
+static void _draw(void)
+{
+	glClear(GL_COLOR_BUFFER_BIT);
+	glBegin(GL_QUADS);
+	glTexCoord2f(0, 0);
+	glVertex2f(-1, 1);
+	glTexCoord2f(1, 0);
+	glVertex2f(1, 1);
+	glTexCoord2f(1, 1);
+	glVertex2f(1, -1);
+	glTexCoord2f(0, 1);
+	glVertex2f(-1, -1);
+	glEnd();
+	SDL_GL_SwapBuffers();
+}
+
+int open_gl_display(u_int8_t vsync)
+{
+	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+	SDL_GL_SetAttribute(SDL_GL_SWAP_CONTROL, vsync);
+	if (_set_mode(EMU_W, EMU_H)) {
+		printf("Could not open an OpenGL window: %s\n", SDL_GetError());
+		return -1;
+	}
+	_draw();
+	return 0;
+}
+
+void resize_gl_display(int w, int h)
+{
+	if (_set_mode(w, h)) {
+		printf("Could not resize the OpenGL window: %s\n", SDL_GetError());
+		return;
+	}
+	_draw();
+}
+
+void present_gl(const frame* f, u_int64_t dirty)
+{
+	int y, top;
+	int width = _hires ? HIRES_WIDTH : WIDTH;
+	int height = _hires ? HIRES_HEIGHT : HEIGHT;
+
+	if (!f) {
+		_draw();
+		return;
+	}
+	if (f->hires != _hires) {
+		/* Switching screens changes every row, and the size of the texture */
+		_hires = f->hires;
+		if (_hires) {
+			unpack_hires_rows(f->hires_screen, ALL_ROWS, _texels);
+		} else {
+			unpack_rows(f->screen, ALL_ROWS, _texels);
+		}
+		_create_texture();
+		_draw();
+		return;
+	}
+	if (_hires) {
+		unpack_hires_rows(f->hires_screen, dirty, _texels);
+	} else {
+		unpack_rows(f->screen, dirty, _texels);
+	}
+
+	/* Upload one band of texture for each run of changed rows */
+	for (y = 0; y < height; y++) {
+		if (!(dirty & (1ULL << y))) {
+			continue;
+		}
+		for (top = y; y + 1 < height && (dirty & (1ULL << (y + 1))); y++);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, top, width, y - top + 1,
+			GL_LUMINANCE, GL_UNSIGNED_BYTE, _texels + top * width);
+	}
+	_draw();
+}
+#endif
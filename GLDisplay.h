@@ -0,0 +1,55 @@
+/*
+ * Presentation of the CHIP-8 screen through OpenGL.
+ *
+ * Instead of expanding every CHIP-8 pixel into SCALE x SCALE pixels on the
+ * CPU, the screen is kept on the GPU as a WIDTH x HEIGHT texture of one
+ * luminance byte per pixel, or HIRES_WIDTH x HIRES_HEIGHT while the hi-res
+ * screen is shown. Presenting uploads only the rows which changed, at most
+ * 2 KB (8 KB in hi-res), and draws one quad over the window, leaving the GPU
+ * to scale it with nearest neighbour filtering. The window can be resized to
+ * any size; the screen keeps its aspect ratio, bordered in black.
+ *
+ * Only present when built with OPENGL defined (and without NO_SDL); link with
+ * the OpenGL library too.
+ *
+ * INFO:
+ * https://www.libsdl.org/release/SDL-1.2.15/docs/html/guidevideoopengl.html
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef GLDISPLAY_H_
+#define GLDISPLAY_H_
+
+/* INCLUDE */
+#include "InstructionSet.h"
+#include "TripleBuffer.h"
+
+#if !defined(NO_SDL) && defined(OPENGL)
+/* PROTOTYPES */
+/*
+ * Open a resizable EMU_W x EMU_H OpenGL window, swapping on vertical sync if
+ * vsync is set, and create the screen texture. Returns 0 on success, -1 if
+ * OpenGL isn't available.
+ */
+int open_gl_display(u_int8_t vsync);
+
+/*
+ * Resize the window to w x h after the user resized it, and redraw the screen
+ * at the new size.
+ */
+void resize_gl_display(int w, int h);
+
+/*
+ * Upload the rows set in dirty from the screen of frame f to the texture,
+ * then draw the whole texture scaled to the window and swap buffers. If f
+ * holds the other screen than the texture, the texture is made again at its
+ * size from every row. With f NULL, what was uploaded before is redrawn.
+ */
+void present_gl(const frame* f, u_int64_t dirty);
+#endif
+
+#endif
@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Headless.h"
+#include "Scheduler.h"
+
+int load_script(const char* path, input_script* script)
+{
+	char line[128];
+	unsigned long n = 0;
+	unsigned long capacity = 16;
+	unsigned long frame;
+	unsigned int mask;
+	key_event* events;
+	FILE* f = fopen(path, "r");
+
+	if (!f) {
+		printf("Input script %s not found\n", path);
+		return -1;
+	}
+	script->events = malloc(capacity * sizeof(key_event));
+	script->count = 0;
+	if (!script->events) {
+		printf("Not enough memory for input script %s\n", path);
+		fclose(f);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		n++;
+		/* Lines may end in CRLF; blank ones may hold spaces */
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '#' || !line[strspn(line, " \t")]) {
+			continue;
+		}
+		if (sscanf(line, "%lu %x", &frame, &mask) != 2 || mask > 0xFFFF
+			|| (script->count
+				&& frame < script->events[script->count - 1].frame)) {
+			printf("Malformed input script %s at line %lu\n", path, n);
+			fclose(f);
+			free_script(script);
+			return -1;
+		}
+		if (script->count == capacity) {
+			capacity *= 2;
+			events = realloc(script->events, capacity * sizeof(key_event));
+			if (!events) {
+				printf("Not enough memory for input script %s\n", path);
+				fclose(f);
+				free_script(script);
+				return -1;
+			}
+			script->events = events;
+		}
+		script->events[script->count].frame = frame;
+		script->events[script->count].mask = mask;
+		script->count++;
+	}
+	fclose(f);
+	return 0;
+}
+
+void free_script(input_script* script)
+{
+	free(script->events);
+	script->events = NULL;
+	script->count = 0;
+}
+
+void run_headless(chip8* c, const headless_config* config,
+	headless_result* result)
+{
+	unsigned long next = 0;
+	u_int32_t n;
+	u_int32_t executed;
+	scheduler s;
+
+	init_scheduler(&s, config->ips);
+	result->cycles = 0;
+	result->executed = 0;
+	result->frames = 0;
+	while (!c->halt && (!config->frames || result->frames < config->frames)
+		&& (!config->cycles || result->cycles < config->cycles)) {
+		/* Apply every key change scheduled up to this frame */
+		while (config->input && next < config->input->count
+			&& config->input->events[next].frame <= result->frames) {
+			set_key_mask(c, config->input->events[next++].mask);
+		}
+
+		n = tick_cycles(&s);
+		if (config->cycles && config->cycles - result->cycles < n) {
+			n = config->cycles - result->cycles;
+		}
+		/* An idle machine skips straight to the end of the frame */
+		executed = run_cycles(c, n);
+		result->cycles += c->idle ? n : executed;
+		result->executed += executed;
+		result->frames++;
+		c->draw = 0;
+		_decrement_timers(c);
+	}
+	result->halt = c->halt;
+}
@@ -0,0 +1,84 @@
+/*
+ * Headless execution of CHIP-8 ROMs.
+ *
+ * Runs a machine for a fixed number of instructions or frames without any
+ * display, sound, or keyboard, so that ROMs can be executed on hosts with no
+ * display at the full speed of the interpreter. Input is supplied by an input
+ * script instead of a keyboard.
+ *
+ * An input script is a text file holding one key change per line in the form
+ *     <frame> <mask>
+ * where frame is the frame number (starting at 0) at which the keys change and
+ * mask is a hexadecimal mask of the CHIP-8 keys held down from that frame on;
+ * bit k of the mask is set when key k is pressed. Lines must be in increasing
+ * frame order. Lines may end in CRLF. Blank lines, even holding spaces, and
+ * lines starting with '#' are ignored.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef HEADLESS_H_
+#define HEADLESS_H_
+
+/* INCLUDE */
+#include "CHIP8Emulator.h"
+
+/* One change of the pressed keys in an input script */
+typedef struct key_event {
+	unsigned long frame; // frame at which the keys change
+	u_int16_t mask;      // keys pressed from then on, bit k for key k
+} key_event;
+
+/* Scripted input for a headless run */
+typedef struct input_script {
+	key_event* events;
+	unsigned long count;
+} input_script;
+
+/* Limits and input for a headless run */
+typedef struct headless_config {
+	unsigned long cycles;      // stop after this many instructions; 0 if none
+	unsigned long frames;      // stop after this many frames; 0 if none
+	const input_script* input; // scripted input, NULL to never press any key
+	u_int32_t ips;             // instructions per second, 0 for DEFAULT_IPS
+} headless_config;
+
+/* Outcome of a headless run */
+typedef struct headless_result {
+	unsigned long cycles;   // instructions executed or skipped while idle
+	unsigned long executed; // instructions actually executed
+	unsigned long frames;   // number of frames started
+	u_int8_t halt;        // HALT_ reason, HALT_NONE if a limit was reached
+} headless_result;
+
+/* PROTOTYPES */
+/*
+ * Read the input script at path into script.
+ *
+ * Returns 0 on success. If the file can't be opened or a line is malformed, an
+ * error message is printed and -1 is returned.
+ */
+int load_script(const char* path, input_script* script);
+
+/*
+ * Release the events held by script.
+ */
+void free_script(input_script* script);
+
+/*
+ * Run machine c without a display until one of the limits in config is reached
+ * or the machine halts; write what happened to result.
+ *
+ * Each frame, the keys given for that frame by the input script are applied,
+ * the instructions one FRAME_RATE-th of a second holds at the ips rate of
+ * config are executed, and the timers are decremented. No time is spent
+ * waiting for the wall clock.
+ * If neither limit is set, the machine runs until it halts.
+ */
+void run_headless(chip8* c, const headless_config* config,
+	headless_result* result);
+
+#endif
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "InstructionSet.h"
+#include "BlockEngine.h"
 
 u_int8_t font_set[SIZE_FS] = {
     0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
@@ -22,241 +23,356 @@ u_int8_t font_set[SIZE_FS] = {
     0xF0, 0x80, 0xF0, 0x80, 0x80  // F
 };
 
-void push(address addr)
+u_int8_t big_font_set[SIZE_BFS] = {
+    0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C, // 0
+    0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, // 1
+    0x3E, 0x7F, 0xC3, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xFF, 0xFF, // 2
+    0x3C, 0x7E, 0xC3, 0x03, 0x0E, 0x0E, 0x03, 0xC3, 0x7E, 0x3C, // 3
+    0x06, 0x0E, 0x1E, 0x36, 0x66, 0xC6, 0xFF, 0xFF, 0x06, 0x06, // 4
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFE, 0x03, 0xC3, 0x7E, 0x3C, // 5
+    0x3E, 0x7C, 0xC0, 0xC0, 0xFC, 0xFE, 0xC3, 0xC3, 0x7E, 0x3C, // 6
+    0xFF, 0xFF, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x60, 0x60, // 7
+    0x3C, 0x7E, 0xC3, 0xC3, 0x7E, 0x7E, 0xC3, 0xC3, 0x7E, 0x3C, // 8
+    0x3C, 0x7E, 0xC3, 0xC3, 0x7F, 0x3F, 0x03, 0x03, 0x3E, 0x7C, // 9
+    0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+    0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, // B
+    0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, // C
+    0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // E
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  // F
+};
+
+void push(chip8* c, address addr)
 {
-	if (sp < (address*) STACK_UP) {
-		printf("Stack overflow\n");
-		exit(EXIT_FAILURE);
+	if (c->sp < STACK_UP) {
+		c->halt = HALT_OVERFLOW;
+		return;
 	}
-	*(sp--) = addr;
+	write_mem(c, c->sp, addr >> 8);
+	write_mem(c, c->sp + 1, addr & 0xFF);
+	c->sp -= sizeof(address);
 }
 
-address pop()
+void write_mem(chip8* c, address a, u_int8_t value)
 {
-	if (sp == (address*) STACK_LOW) {
-		printf("Empty stack\n");
-		exit(EXIT_FAILURE);
+	a = MEM(a);
+	c->RAM[a] = value;
+	c->touched |= 1ULL << (a / SIZE_PAGE);
+	if (c->cache) {
+		/* Both instructions which may contain this byte are now stale */
+		c->cache[a].op = OP_NONE;
+		c->cache[MEM(a - 1)].op = OP_NONE;
+	}
+	if (c->blocks) {
+		invalidate_blocks(c, a);
 	}
-	return *(++sp);
 }
 
-void CLS()
+address pop(chip8* c)
 {
-	memset(screen, 0, WIDTH * HEIGHT);
+	if (c->sp == STACK_LOW) {
+		c->halt = HALT_UNDERFLOW;
+		return 0;
+	}
+	c->sp += sizeof(address);
+	return INSTR(c->RAM[c->sp], c->RAM[c->sp + 1]);
 }
 
-void RET()
+void UNKNOWN(chip8* c, const decoded* d)
 {
-	PC = pop() + 2;
+	c->halt = HALT_UNKNOWN;
 }
 
-void JP(instruction i)
+void CLS(chip8* c, const decoded* d)
 {
-	PC = ADDR(i);
+	if (c->hires) {
+		memset(c->hires_screen, 0, sizeof(c->hires_screen));
+		c->top = 0;
+	} else {
+		memset(c->screen, 0, sizeof(c->screen));
+	}
+	c->dirty = ALL_ROWS;
 }
 
-void CALL(instruction i)
+void RET(chip8* c, const decoded* d)
 {
-	push(PC - 2);
-	PC = ADDR(i);
+	c->PC = pop(c) + 2;
 }
 
-void SE(instruction i)
+void JP(chip8* c, const decoded* d)
 {
-	if (v[VX(i)] == BYTE(i)) {
-		PC += 2;
+	address from = c->PC;
+	instruction ldd = INSTR(c->RAM[d->nnn], c->RAM[MEM(d->nnn + 1)]);
+
+	c->PC = d->nnn;
+	/* Jumping to itself, nothing can happen until the next tick */
+	if (d->nnn + 2 == from) {
+		c->idle = 1;
+	}
+	/* Jumping back to LDD Vx; SE Vx, 0 while the delay timer is running */
+	if (d->nnn + 6 == from && c->delay_timer && (ldd & 0xF0FF) == 0xF007
+		&& INSTR(c->RAM[MEM(d->nnn + 2)], c->RAM[MEM(d->nnn + 3)])
+			== (0x3000 | (ldd & 0x0F00))) {
+		c->idle = 1;
 	}
 }
 
-void SNEI(instruction i)
+void CALL(chip8* c, const decoded* d)
 {
-	if (v[VX(i)] != BYTE(i)) {
-		PC += 2;
+	push(c, c->PC - 2);
+	c->PC = d->nnn;
+}
+
+void SE(chip8* c, const decoded* d)
+{
+	if (c->v[d->x] == d->kk) {
+		c->PC += 2;
 	}
 }
 
-void SR(instruction i)
+void SNEI(chip8* c, const decoded* d)
 {
-	if (v[VX(i)] == v[VY(i)]) {
-		PC += 2;
+	if (c->v[d->x] != d->kk) {
+		c->PC += 2;
 	}
 }
 
-void LDB(instruction i)
+void SR(chip8* c, const decoded* d)
 {
-	v[VX(i)] = BYTE(i);
+	if (c->v[d->x] == c->v[d->y]) {
+		c->PC += 2;
+	}
 }
 
-void ADDI(instruction i)
+void LDB(chip8* c, const decoded* d)
 {
-	v[VX(i)] += BYTE(i);
+	c->v[d->x] = d->kk;
 }
 
-void LDR(instruction i)
+void ADDI(chip8* c, const decoded* d)
 {
-	v[VX(i)] = v[VY(i)];
+	c->v[d->x] += d->kk;
 }
 
-void OR(instruction i)
+void LDR(chip8* c, const decoded* d)
 {
-	v[VX(i)] |= v[VY(i)];
+	c->v[d->x] = c->v[d->y];
 }
 
-void AND(instruction i)
+void OR(chip8* c, const decoded* d)
 {
-	v[VX(i)] &= v[VY(i)];
+	c->v[d->x] |= c->v[d->y];
 }
 
-void XOR(instruction i)
+void AND(chip8* c, const decoded* d)
 {
-	v[VX(i)] ^= v[VY(i)];
+	c->v[d->x] &= c->v[d->y];
 }
 
-void ADD(instruction i)
+void XOR(chip8* c, const decoded* d)
 {
-	v[0xF] = v[VX(i)] > 0xFF - v[VY(i)] ? 1 : 0;
-	v[VX(i)] += v[VY(i)];
+	c->v[d->x] ^= c->v[d->y];
+}
+
+void ADD(chip8* c, const decoded* d)
+{
+	c->v[0xF] = c->v[d->x] > 0xFF - c->v[d->y] ? 1 : 0;
+	c->v[d->x] += c->v[d->y];
 
 }
 
-void SUB(instruction i)
+void SUB(chip8* c, const decoded* d)
 {
-	v[0xF] = v[VY(i)] > v[VX(i)] ? 0 : 1;
-	v[VX(i)] -= v[VY(i)];
+	c->v[0xF] = c->v[d->y] > c->v[d->x] ? 0 : 1;
+	c->v[d->x] -= c->v[d->y];
 }
 
-void SHR(instruction i)
+void SUBN(chip8* c, const decoded* d)
 {
-	v[0xF] = LSBI(v[VX(i)]);
-	v[VX(i)] >>= 1;
+	c->v[0xF] = c->v[d->x] > c->v[d->y] ? 0 : 1;
+	c->v[d->x] = c->v[d->y] - c->v[d->x];
 }
 
-void SUBN(instruction i)
+void SNE(chip8* c, const decoded* d)
 {
-	v[0xF] = v[VX(i)] > v[VY(i)] ? 0 : 1;
-	v[VX(i)] = v[VY(i)] - v[VX(i)];
+	if (c->v[d->x] != c->v[d->y]) {
+		c->PC += 2;
+	}
 }
 
-void SHL(instruction i)
+void LDI(chip8* c, const decoded* d)
 {
-	v[0xF] = MSBR(v[VX(i)]);
-	v[VX(i)] <<= 1;
+	c->I = d->nnn;
 }
 
-void SNE(instruction i)
+void RND(chip8* c, const decoded* d)
 {
-	if (v[VX(i)] != v[VY(i)]) {
-		PC += 2;
-	}
+	/* xorshift32 */
+	c->rng ^= c->rng << 13;
+	c->rng ^= c->rng >> 17;
+	c->rng ^= c->rng << 5;
+	c->v[d->x] = (c->rng >> 24) & d->kk;
 }
 
-void LDI(instruction i)
+void SKP(chip8* c, const decoded* d)
 {
-	I = ADDR(i);
+	if (c->keys[c->v[d->x]]) {
+		c->PC += 2;
+	}
 }
 
-void JPR(instruction i)
+void SKNP(chip8* c, const decoded* d)
 {
-	PC = ADDR(i) + v[0x0];
+	if (!c->keys[c->v[d->x]]) {
+		c->PC += 2;
+	}
 }
 
-void RND(instruction i)
+void LDD(chip8* c, const decoded* d)
 {
-	v[VX(i)] = (rand() % 256) & BYTE(i);
+	c->v[d->x] = c->delay_timer;
 }
 
-void DRW(instruction i)
+void LDK(chip8* c, const decoded* d)
 {
-	int x;
-	int y;
-	u_int8_t p;
-	u_int8_t Vx = v[VX(i)];
-	u_int8_t Vy = v[VY(i)];
-	u_int8_t height = LSN(i);
-	v[0xF] = 0;
-
-	for (y = 0; y < height; y++) {
-		p = RAM[I + y];
-		for (x = 0; x < 8; x++) {
-			if (p & (0x80 >> x)) {
-				if (screen[x + Vx + (y + Vy) * WIDTH]) {
-					v[0xF] = 1;
-				}
-				screen[x + Vx + (y + Vy) * WIDTH] ^= 1;
-			}
+	for (int j = 0; j < NUM_REGS; j++) {
+		if (c->keys[j]) {
+			c->v[d->x] = j;
+			return;
 		}
 	}
+	/* Repeat instruction if no key pressed, once the keys may have changed */
+	c->PC -= 2;
+	c->idle = 1;
 }
 
-void SKP(instruction i)
+void STD(chip8* c, const decoded* d)
 {
-	if (keys[v[VX(i)]]) {
-		PC += 2;
-	}
+	c->delay_timer = c->v[d->x];
 }
 
-void SKNP(instruction i)
+void STS(chip8* c, const decoded* d)
 {
-	if (!keys[v[VX(i)]]) {
-		PC += 2;
-	}
+	c->sound_timer = c->v[d->x];
 }
 
-void LDD(instruction i)
+void IINC(chip8* c, const decoded* d)
 {
-	v[VX(i)] = delay_timer;
+	c->v[0xF] = c->I + c->v[d->x] > 0xFFF ? 1 : 0;
+	c->I += c->v[d->x];
 }
 
-void LDK(instruction i)
+void LDF(chip8* c, const decoded* d)
 {
-	for (int j = 0; j < NUM_REGS; j++) {
-		if (keys[j]) {
-			v[VX(i)] = j;
-			return;
+	c->I = c->v[d->x] * 5;
+}
+
+void BCD(chip8* c, const decoded* d)
+{
+	write_mem(c, c->I, c->v[d->x] / 100);
+	write_mem(c, c->I + 1, (c->v[d->x] / 10) % 10);
+	write_mem(c, c->I + 2, (c->v[d->x] % 100) % 10);
+}
+
+void SCD(chip8* c, const decoded* d)
+{
+	int y;
+
+	if (c->hires) {
+		/* The bottom rows become the top ones, cleared */
+		c->top = (c->top - d->n) & (HIRES_HEIGHT - 1);
+		for (y = 0; y < d->n; y++) {
+			memset(HIRES_ROW(c, y), 0, sizeof(c->hires_screen[0]));
+		}
+	} else {
+		memmove(c->screen + d->n, c->screen,
+			(HEIGHT - d->n) * sizeof(c->screen[0]));
+		memset(c->screen, 0, d->n * sizeof(c->screen[0]));
+	}
+	c->dirty = ALL_ROWS;
+	c->draw = 1;
+}
+
+void SCR(chip8* c, const decoded* d)
+{
+	int y, k;
+
+	if (c->hires) {
+		for (y = 0; y < HIRES_HEIGHT; y++) {
+			for (k = HIRES_WORDS - 1; k > 0; k--) {
+				c->hires_screen[y][k] = c->hires_screen[y][k] >> 4
+					| c->hires_screen[y][k - 1] << 60;
+			}
+			c->hires_screen[y][0] >>= 4;
+		}
+	} else {
+		for (y = 0; y < HEIGHT; y++) {
+			c->screen[y] >>= 4;
 		}
 	}
-	/* Repeat instruction if no key pressed */
-	PC -= 2;
+	c->dirty = ALL_ROWS;
+	c->draw = 1;
 }
 
-void STD(instruction i)
+void SCL(chip8* c, const decoded* d)
 {
-	delay_timer = v[VX(i)];
+	int y, k;
+
+	if (c->hires) {
+		for (y = 0; y < HIRES_HEIGHT; y++) {
+			for (k = 0; k < HIRES_WORDS - 1; k++) {
+				c->hires_screen[y][k] = c->hires_screen[y][k] << 4
+					| c->hires_screen[y][k + 1] >> 60;
+			}
+			c->hires_screen[y][HIRES_WORDS - 1] <<= 4;
+		}
+	} else {
+		for (y = 0; y < HEIGHT; y++) {
+			c->screen[y] <<= 4;
+		}
+	}
+	c->dirty = ALL_ROWS;
+	c->draw = 1;
 }
 
-void STS(instruction i)
+void EXIT(chip8* c, const decoded* d)
 {
-	sound_timer = v[VX(i)];
+	c->halt = HALT_EXIT;
 }
 
-void IINC(instruction i)
+void LOW(chip8* c, const decoded* d)
 {
-	v[0xF] = I + v[VX(i)] > 0xFFF ? 1 : 0;
-	I += v[VX(i)];
+	c->hires = 0;
+	CLS(c, d);
+	c->draw = 1;
 }
 
-void LDF(instruction i)
+void HIGH(chip8* c, const decoded* d)
 {
-	I = v[VX(i)] * 5;
+	c->hires = 1;
+	CLS(c, d);
+	c->draw = 1;
 }
 
-void BCD(instruction i)
+void LDHF(chip8* c, const decoded* d)
 {
-	RAM[I] = v[VX(i)] / 100;
-	RAM[I + 1] = (v[VX(i)] / 10) % 10;
-	RAM[I + 2] = (v[VX(i)] % 100) % 10;
+	c->I = BIG_FONT + c->v[d->x] * 10;
 }
 
-void STA(instruction i)
+void STR(chip8* c, const decoded* d)
 {
-	for (int j = 0; j <= VX(i); j++) {
-		RAM[I + j] = v[j];
+	int j;
+
+	for (j = 0; j <= d->x && j < NUM_FLAGS; j++) {
+		c->flags[j] = c->v[j];
 	}
 }
 
-void LDA(instruction i)
+void LDRF(chip8* c, const decoded* d)
 {
-	for (int j = 0; j <= VX(i); j++) {
-		v[j] = RAM[I + j];
+	int j;
+
+	for (j = 0; j <= d->x && j < NUM_FLAGS; j++) {
+		c->v[j] = c->flags[j];
 	}
 }
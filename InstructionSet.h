@@ -13,6 +13,9 @@
 #ifndef INSTRUCTIONSET_H_
 #define INSTRUCTIONSET_H_
 
+/* INCLUDE */
+#include <stdint.h>
+
 /* Space out the stack so that it can hold 16 2-byte addresses. Upper and lower
  * boundaries are separated by 30 because using zero-indexing, it can hold 16
  * 2-byte addresses.
@@ -20,17 +23,34 @@
 #define STACK_UP  0xEA0 // upper bound of the stack
 #define STACK_LOW 0xEBE // lower bound of the stack
 #define SIZE_MEM  4096  // number of bytes in memory
+#define SIZE_PAGE 64    // bytes of memory covered by one bit of touched
 #define SIZE_FS   80    // size of the font-set
+#define BIG_FONT  0x50  // address of the SUPER-CHIP big font-set
+#define SIZE_BFS  160   // size of the SUPER-CHIP big font-set
 #define NUM_REGS  16    // number of registers
 #define NUM_KEYS  16    // number of CHIP-8 input keys
+#define NUM_FLAGS 8     // number of SUPER-CHIP RPL user flags
 
 #define WHITE  0
 #define BLACK  0xFFFFFFFF
 #define WIDTH  64  // width of CHIP-8 screen
 #define HEIGHT 32  // height of CHIP-8 screen
+#define HIRES_WIDTH  128 // width of SUPER-CHIP hi-res screen
+#define HIRES_HEIGHT 64  // height of SUPER-CHIP hi-res screen
+#define HIRES_WORDS  (HIRES_WIDTH / 64) // 64-bit words per hi-res screen row
 #define EMU_W  640 // width of emulator screen
 #define EMU_H  320 // height of emulator screen
 #define BPP    32  // Bits Per Pixel on emulator screen
+#define SCALE  (EMU_W / WIDTH) // emulator pixels per CHIP-8 pixel on each axis
+#define HIRES_SCALE (EMU_W / HIRES_WIDTH) // emulator pixels per hi-res pixel
+#define ALL_ROWS (~0ULL)       // dirty mask with every row of either screen set
+
+/* Reasons a machine stops executing, held in its halt register */
+#define HALT_NONE      0 // machine is running
+#define HALT_OVERFLOW  1 // CALL with a full stack
+#define HALT_UNDERFLOW 2 // RET with an empty stack
+#define HALT_UNKNOWN   3 // instruction is not a member of the instruction set
+#define HALT_EXIT      4 // program ended itself with EXIT
 
 /* Create an instruction from two adjacent locations in memory */
 #define INSTR(pc, pc_next) ((pc) << 8 | (pc_next))
@@ -50,89 +70,356 @@
 #define MSBR(v) ((v) >> 7)
 /* Least Significant Bit */
 #define LSBI(v) ((v) & 0x1)
+/* Pixel at column x of a packed screen row */
+#define PIXEL(row, x) (((row) >> (WIDTH - 1 - (x))) & 1)
+/* Rotate a packed screen row right by n pixels, wrapping around the edge */
+#define ROTR(row, n) ((row) >> (n) | (row) << (-(n) & (WIDTH - 1)))
+/* Row y of the hi-res screen of machine c, undoing the ring of its rows */
+#define HIRES_ROW(c, y) \
+	((c)->hires_screen[((c)->top + (y)) & (HIRES_HEIGHT - 1)])
+/* Wrap an address so that it lies within memory */
+#define MEM(a) ((a) & (SIZE_MEM - 1))
+
+/*
+ * Operations of the instruction set. Decoding an instruction yields one of these
+ * indices, which selects the method in the handlers of the machine that
+ * executes it.
+ */
+#define OP_UNKNOWN 0 // not a member of the instruction set
+#define OP_CLS     1
+#define OP_RET     2
+#define OP_JP      3
+#define OP_CALL    4
+#define OP_SE      5
+#define OP_SNEI    6
+#define OP_SR      7
+#define OP_LDB     8
+#define OP_ADDI    9
+#define OP_LDR     10
+#define OP_OR      11
+#define OP_AND     12
+#define OP_XOR     13
+#define OP_ADD     14
+#define OP_SUB     15
+#define OP_SHR     16
+#define OP_SUBN    17
+#define OP_SHL     18
+#define OP_SNE     19
+#define OP_LDI     20
+#define OP_JPR     21
+#define OP_RND     22
+#define OP_DRW     23
+#define OP_SKP     24
+#define OP_SKNP    25
+#define OP_LDD     26
+#define OP_LDK     27
+#define OP_STD     28
+#define OP_STS     29
+#define OP_IINC    30
+#define OP_LDF     31
+#define OP_BCD     32
+#define OP_STA     33
+#define OP_LDA     34
+/* SUPER-CHIP operations */
+#define OP_SCD     35
+#define OP_SCR     36
+#define OP_SCL     37
+#define OP_EXIT    38
+#define OP_LOW     39
+#define OP_HIGH    40
+#define OP_DRWX    41
+#define OP_LDHF    42
+#define OP_STR     43
+#define OP_LDRF    44
+#define NUM_OPS    45 // number of operations, including OP_UNKNOWN
+#define OP_NONE    0xFF // marks a predecoded entry which is not decoded yet
 
 typedef unsigned short instruction; // instructions are 16-bit in granularity
 typedef unsigned short address; // addresses for variables like PC are 16-bit
+typedef uint64_t       u_int64_t;
+typedef unsigned int   u_int32_t;
 typedef unsigned short u_int16_t;
 typedef unsigned char  u_int8_t;
 
 /*
- * CHIP-8 memory consists of 4K (4096) locations. Memory is divided amongst:
- *     CHIP-8 interpreter   (0x000 - 0x1FF)
- *     Program in execution (0x200 - 0xE99)
- *     16 level stack       (0xEA0 - 0xEFF)
- *     Display refresh      (0xF00 - 0xFFF)
+ * Instruction with its operation decoded and its operands unpacked, so that it
+ * can be executed without looking at the instruction again.
  */
-u_int8_t RAM[SIZE_MEM];
+typedef struct decoded {
+	u_int8_t op;   // OP_ value of the operation
+	u_int8_t x;    // Vx specifier
+	u_int8_t y;    // Vy specifier
+	u_int8_t n;    // least significant nibble
+	u_int8_t kk;   // least significant byte
+	u_int16_t nnn; // address
+} decoded;
 
-/* Index (I) and program counter (PC) registers have 2 byte granularity */
-u_int16_t PC;
-u_int16_t I;
+#ifdef TRACE
+#ifndef TRACE_SIZE
+#define TRACE_SIZE 1024 // instructions kept in a trace, must be a power of 2
+#endif
 
-/* Font-set for the CHIP-8 */
-u_int8_t font_set[SIZE_FS];
+/* Machine state recorded for one executed instruction, see Trace.h */
+typedef struct trace_entry {
+	u_int16_t pc;         // address of the instruction
+	instruction i;        // the instruction
+	u_int16_t I;          // I before the instruction
+	u_int16_t sp;         // stack pointer before the instruction
+	u_int8_t vx;          // Vx before the instruction
+	u_int8_t vy;          // Vy before the instruction
+	u_int8_t vf;          // VF before the instruction
+	u_int8_t delay_timer; // delay timer before the instruction
+} trace_entry;
+#endif
 
-/* The CHIP-8 has 16 8-bit (1 byte) registers, labeled V0, V1, ..., VF */
-u_int8_t v[NUM_REGS];
+#ifdef PROFILE
+#ifndef PROFILE_NODES
+#define PROFILE_NODES 512 // subroutine call paths a profile tells apart
+#endif
 
-/* Input keys for the CHIP-8 emulator. Standard CHIP-8 hardware input is ordered
- * in the following way:
- *     1 2 3 C
- *     4 5 6 D
- *     7 8 9 E
- *     A 0 B F
- */
-u_int8_t keys[NUM_KEYS];
+/* One path of subroutine calls in a profile, see Profile.h */
+typedef struct profile_node {
+	u_int64_t cycles;  // instructions executed on this path, not in callees
+	u_int16_t entry;   // address of the subroutine called last on the path
+	u_int16_t parent;  // path this one was called from
+	u_int16_t child;   // first path called from this one, 0 if none
+	u_int16_t sibling; // next path called from the same parent, 0 if none
+} profile_node;
+
+/* Execution profile of a machine, see Profile.h */
+typedef struct profile {
+	u_int64_t ops[NUM_OPS];      // executions of each OP_ operation
+	u_int64_t pcs[SIZE_MEM];     // executions of the instruction at each address
+	profile_node nodes[PROFILE_NODES]; // call paths, 0 being the program itself
+	u_int16_t num_nodes;         // call paths in use
+	u_int16_t current;           // call path currently executing
+	u_int16_t untracked;         // calls within current which got no path
+} profile;
+#endif
 
 /*
- * CHIP-8 has stack which stores address stored in PC before a subroutine call
- * which is then restored after the call. This emulator supports 16 levels
- * within the stack, defined as STACK_BOUND
- *
- * Stack pointer points to first empty location on the stack.
+ * Method executing one operation of the instruction set. Every operation
+ * receives the operands predecoded from its instruction, even those which
+ * have no operands.
  */
-address* sp;
+struct chip8;
+typedef void (*handler)(struct chip8* c, const decoded* d);
 
-/* Screen has 2K (2048) pixels (64 x 32). A pixel is either on (1) or off (0) */
-u_int8_t screen[WIDTH * HEIGHT];
+/* Font-set for the CHIP-8, shared by every machine */
+extern u_int8_t font_set[SIZE_FS];
 
-/* CHIP-8 has two timers which count down at 60 Hz to 0 from wherever set */
-u_int8_t delay_timer;
-/* CHIP-8 sound timer produces sound whenever it contains a non-zero value */
-u_int8_t sound_timer;
+/* Big font-set of the SUPER-CHIP, 8 x 10 digits, shared by every machine */
+extern u_int8_t big_font_set[SIZE_BFS];
+
+/*
+ * Machine context holding the complete state of one emulated CHIP-8.
+ *
+ * Every instruction operates on the machine passed to it rather than on global
+ * state, so any number of machines can be emulated side by side in the same
+ * process. Small, frequently accessed registers are placed first so that they
+ * share a cache line; RAM and the screen follow.
+ */
+typedef struct chip8 {
+	/* The CHIP-8 has 16 8-bit (1 byte) registers, labeled V0, V1, ..., VF */
+	u_int8_t v[NUM_REGS];
+
+	/* Index (I) and program counter (PC) registers have 2 byte granularity */
+	u_int16_t PC;
+	u_int16_t I;
+
+	/*
+	 * CHIP-8 has stack which stores address stored in PC before a subroutine
+	 * call which is then restored after the call. This emulator supports 16
+	 * levels within the stack, located between STACK_UP and STACK_LOW.
+	 *
+	 * Stack pointer holds the RAM address of the first empty location on the
+	 * stack. Keeping it as an address rather than a pointer lets a machine be
+	 * copied or moved without fixing it up.
+	 */
+	u_int16_t sp;
+
+	/* CHIP-8 has two timers which count down at 60 Hz from wherever set */
+	u_int8_t delay_timer;
+	/* CHIP-8 sound timer produces sound whenever it holds a non-zero value */
+	u_int8_t sound_timer;
+
+	/* Signal to refresh the screen after it's been edited */
+	u_int8_t draw;
+
+	/*
+	 * Non-zero once the machine has stopped, holding one of the HALT_ reasons.
+	 * Errors are reported through this register instead of ending the process
+	 * so that one faulty ROM cannot take down other machines.
+	 */
+	u_int8_t halt;
+
+	/*
+	 * Set when the machine is known to be waiting, for the next timer tick or
+	 * for a key press, without doing anything else. Execution stops until the
+	 * timers are decremented or the keys change, which clear it.
+	 */
+	u_int8_t idle;
+
+	/*
+	 * Input keys for the CHIP-8 emulator. Standard CHIP-8 hardware input is
+	 * ordered in the following way:
+	 *     1 2 3 C
+	 *     4 5 6 D
+	 *     7 8 9 E
+	 *     A 0 B F
+	 */
+	u_int8_t keys[NUM_KEYS];
+
+	/*
+	 * CHIP-8 memory consists of 4K (4096) locations. Memory is divided amongst:
+	 *     CHIP-8 interpreter   (0x000 - 0x1FF), holding both font-sets
+	 *     Program in execution (0x200 - 0xE99)
+	 *     16 level stack       (0xEA0 - 0xEFF)
+	 *     Display refresh      (0xF00 - 0xFFF)
+	 */
+	u_int8_t RAM[SIZE_MEM];
+
+	/*
+	 * Screen has 2K (2048) pixels (64 x 32). A pixel is either on (1) or off
+	 * (0). Each row is packed into one 64-bit word with the leftmost pixel in
+	 * the most significant bit; use PIXEL to read a single pixel.
+	 */
+	u_int64_t screen[HEIGHT];
+
+	/*
+	 * SUPER-CHIP hi-res screen of 8K pixels (128 x 64), shown instead of
+	 * screen while hires is set. Each row is packed into HIRES_WORDS words,
+	 * leftmost first, each with its leftmost pixel in the most significant
+	 * bit. The rows form a ring starting at row top, so scrolling up or down
+	 * moves top and clears the rows scrolled in rather than moving every
+	 * other row; use HIRES_ROW to find a row.
+	 */
+	u_int64_t hires_screen[HIRES_HEIGHT][HIRES_WORDS];
+
+	/*
+	 * Rows of the screen shown changed since it was last presented; bit y is
+	 * set when row y has changed. Switching screens marks every row.
+	 */
+	u_int64_t dirty;
+
+	/* Showing the hi-res screen (1) or the CHIP-8 screen (0) */
+	u_int8_t hires;
+
+	/* Row of hires_screen holding the top row of the hi-res screen */
+	u_int8_t top;
+
+	/* SUPER-CHIP RPL user flags, stored and loaded by STR and LDRF */
+	u_int8_t flags[NUM_FLAGS];
+
+	/*
+	 * State of the machine's own xorshift random number generator, used by
+	 * RND; never zero. Set with seed_rng.
+	 */
+	u_int32_t rng;
+
+	/* Execution engine the machine runs on, one of the ENGINE_ values */
+	u_int8_t engine;
+
+	/* Quirk profile the machine runs with, one of the QUIRKS_ values */
+	u_int8_t quirks;
+
+	/*
+	 * Method executing each operation, indexed by OP_ value, from the handler
+	 * table of the quirk profile (see Quirks.h).
+	 */
+	const handler* handlers;
+
+	/*
+	 * Predecoded instruction cache, indexed by the address of the instruction.
+	 * Only allocated when the machine runs on ENGINE_CACHE; NULL otherwise.
+	 */
+	decoded* cache;
+
+	/*
+	 * Translated basic blocks, defined in BlockEngine.h. Only allocated when
+	 * the machine runs on ENGINE_BLOCK; NULL otherwise.
+	 */
+	struct translation* blocks;
+
+	/*
+	 * Pages of memory written since the machine was last initialized or reset;
+	 * bit p is set when a byte in page p, of SIZE_PAGE bytes, has been written
+	 * by write_mem. Resetting only copies these pages back.
+	 */
+	u_int64_t touched;
+
+#ifdef TRACE
+	/* Ring buffer of the last TRACE_SIZE instructions executed */
+	trace_entry trace[TRACE_SIZE];
+	/* Number of instructions ever recorded in trace */
+	u_int32_t trace_next;
+#endif
+
+#ifdef PROFILE
+	/* Counts of what the machine executed */
+	profile prof;
+#endif
+} chip8;
 
 /* PROTOTYPES */
 /*
  * Push an address onto the stack if it's not full; move up the stack pointer.
  *
- * If the stack is full, the emulator will end.
+ * If the stack is full, the machine halts with HALT_OVERFLOW.
+ */
+void push(chip8* c, address addr);
+
+/*
+ * Write value to memory address a, wrapping a to lie within memory.
+ *
+ * Every write to memory made by an instruction goes through this method so that
+ * any predecoded or translated copy of the instructions at a is discarded; ROMs
+ * which modify their own code therefore keep running correctly. The page of a
+ * is marked as touched.
  */
-void push(address addr);
+void write_mem(chip8* c, address a, u_int8_t value);
 
 /*
  * Return which address is at the top of the stack; decrement the stack pointer.
  *
- * If the stack is empty, the emulator will end.
+ * If the stack is empty, the machine halts with HALT_UNDERFLOW and 0 is
+ * returned.
+ */
+address pop(chip8* c);
+
+/*
+ * Methods executing each operation. SHR, SHL, JPR, DRW, DRWX, STA and LDA
+ * behave differently under each quirk profile, so they are defined once per
+ * profile in QuirkTemplate.h instead.
+ */
+
+/*
+ * Instruction is not a member of the instruction set: halt the machine with
+ * HALT_UNKNOWN.
  */
-address pop();
+void UNKNOWN(chip8* c, const decoded* d);
 
 /*
- * Clear CHIP-8 screen.
+ * Clear the screen shown, marking every row as dirty.
  */
-void CLS();
+void CLS(chip8* c, const decoded* d);
 
 /*
  * Return from subroutine: set PC to address at the top of the stack + 2 so
  * whichever instruction was at PC doesn't get repeated, decrements stack
  * pointer.
  */
-void RET();
+void RET(chip8* c, const decoded* d);
 
 /*
  * Jump to address. Instruction should have form INNN where NNN is the address
  * to jump to. Sets PC to NNN.
+ *
+ * Jumps which are known to wait for the next timer tick mark the machine as
+ * idle: a jump to itself, and a jump back to a loop of LDD Vx; SE Vx, 0; JP
+ * while the delay timer is not yet 0.
  */
-void JP(instruction i);
+void JP(chip8* c, const decoded* d);
 
 /*
  * Call subroutine at address. Instruction should have form 2NNN where NNN is
@@ -140,177 +427,205 @@ void JP(instruction i);
  *
  * Pushes PC for this instruction onto the stack; sets PC equal to NNN.
  */
-void CALL(instruction i);
+void CALL(chip8* c, const decoded* d);
 
 /*
  * Skips next instruction if value held in register specified in instruction
  * equals value in instruction.
  */
-void SE(instruction i);
+void SE(chip8* c, const decoded* d);
 
 /*
  * Skips next instruction if value held in register specified in instruction
  * does not equal immediate value specified in least significant byte of
  * instruction.
  */
-void SNEI(instruction i);
+void SNEI(chip8* c, const decoded* d);
 
 /*
  * Skips next instruction if value held in register specified in instruction
  * equals value held in other register specified in instruction.
  */
-void SR(instruction i);
+void SR(chip8* c, const decoded* d);
 
 /*
  * Load immediate byte value specified in instruction into register specified in
  * instruction.
  */
-void LDB(instruction i);
+void LDB(chip8* c, const decoded* d);
 
 /*
  * Add immediate value specified in instruction to register specified in
  * instruction.
  */
-void ADDI(instruction i);
+void ADDI(chip8* c, const decoded* d);
 
 /*
  * Load value located in register specified in instruction to other register
  * specified in instruction.
  */
-void LDR(instruction i);
+void LDR(chip8* c, const decoded* d);
 
 /*
  * Bitwise OR value held in register Vx with value held in register Vy; store
  * the result in Vx.
  */
-void OR(instruction i);
+void OR(chip8* c, const decoded* d);
 
 /*
  * Bitwise AND value stored in Vx with value stored in Vy; store result into Vx.
  */
-void AND(instruction i);
+void AND(chip8* c, const decoded* d);
 
 /*
  * Bitwise XOR value in register Vx with value in Vy; store in Vx.
  */
-void XOR(instruction i);
+void XOR(chip8* c, const decoded* d);
 
 /*
  * Add value in Vy to value already stored in Vx. VF is set to 1 if there will
  * be overflow from the addition.
  */
-void ADD(instruction i);
+void ADD(chip8* c, const decoded* d);
 
 /*
  * Subtract value in Vy from value held in Vx. VF is set to 0 if Vy is greater
  * than Vx; 1 otherwise.
  */
-void SUB(instruction i);
-
-/*
- * Perform one unsigned right shift on the value in Vx; store in Vx. VF is set
- * to the least significant bit of Vx.
- */
-void SHR(instruction i);
+void SUB(chip8* c, const decoded* d);
 
 /*
  * Vx is set to Vx subtracted from Vy. VF is set to 0 if Vx is greater than Vy;
  * 1 otherwise.
  */
-void SUBN(instruction i);
-
-/*
- * Performs one left shift on the value in Vx; store value in Vx. VF is set to
- * the most significant bit in Vx.
- */
-void SHL(instruction i);
+void SUBN(chip8* c, const decoded* d);
 
 /*
  * Skip next instruction if value in Vx does not equal value in Vy.
  */
-void SNE(instruction i);
+void SNE(chip8* c, const decoded* d);
 
 /*
  * Load into I variable immediate value stored in least significant three
  * nibbles of the instruction.
  */
-void LDI(instruction i);
-
-/*
- * Set PC to least significant three nibbles of instruction + value in V0.
- */
-void JPR(instruction i);
+void LDI(chip8* c, const decoded* d);
 
 /*
  * Generate a random integer from 0 to 255 inclusive and perform a bitwise AND
  * on the result with the least significant byte of the instruction; store in
  * Vx.
+ *
+ * Random numbers come from the machine's own generator, so machines seeded
+ * alike produce the same numbers regardless of any other machine.
  */
-void RND(instruction i);
-
-/*
- * Draw sprite onto the CHIP-8 screen at location (Vx, Vy), set VF = collision.
- */
-void DRW(instruction i);
+void RND(chip8* c, const decoded* d);
 
 /*
  * Skip the next instruction if the key specified by the value in register Vx is
  * currently pressed.
  */
-void SKP(instruction i);
+void SKP(chip8* c, const decoded* d);
 
 /*
  * Skip the next instruction if the key specified by the value in register Vx is
  * currently not pressed.
  */
-void SKNP(instruction i);
+void SKNP(chip8* c, const decoded* d);
 
 /*
  * Value of delay_timer is placed in Vx
  */
-void LDD(instruction i);
+void LDD(chip8* c, const decoded* d);
 
 /*
  * Halt execution until a key is pressed, value of key is stored in Vx.
+ *
+ * While no key is pressed, the instruction is repeated and the machine is
+ * marked as idle until the keys change or the next timer tick.
  */
-void LDK(instruction i);
+void LDK(chip8* c, const decoded* d);
 
 /*
  * Store Vx in delay_timer.
  */
-void STD(instruction i);
+void STD(chip8* c, const decoded* d);
 
 /*
  * Store Vx in sound_timer.
  */
-void STS(instruction i);
+void STS(chip8* c, const decoded* d);
 
 /*
  * Increment I register by value in Vx. VF is 1 if overflow; 0 otherwise.
  */
-void IINC(instruction i);
+void IINC(chip8* c, const decoded* d);
 
 /*
  * Load location of sprite in Vx into I. Value in Vx ranges from 0x0 to 0xF.
  * This method sets I to the location of that sprite. Each sprite has five
  * 8-bit values in memory, so the value in Vx is multiplied by five.
  */
-void LDF(instruction i);
+void LDF(chip8* c, const decoded* d);
 
 /*
  * Store BCD representation of value in Vx in memory locations I for hundreds
  * place, I + 1 for tens place, I + 2 for ones place.
  */
-void BCD(instruction i);
+void BCD(chip8* c, const decoded* d);
+
+/*
+ * SUPER-CHIP methods. The scrolls move the screen shown by pixels of its own
+ * size, marking every row as dirty; pixels scrolled in are off. The CHIP-8
+ * screen is small enough to move row by row, while the hi-res one moves the
+ * start of its ring of rows up or down and shifts words left or right.
+ */
+
+/*
+ * Scroll the screen down by the number of rows in the least significant
+ * nibble of the instruction.
+ */
+void SCD(chip8* c, const decoded* d);
+
+/*
+ * Scroll the screen right by 4 pixels.
+ */
+void SCR(chip8* c, const decoded* d);
+
+/*
+ * Scroll the screen left by 4 pixels.
+ */
+void SCL(chip8* c, const decoded* d);
+
+/*
+ * End the program: halt the machine with HALT_EXIT.
+ */
+void EXIT(chip8* c, const decoded* d);
+
+/*
+ * Show the CHIP-8 screen, cleared.
+ */
+void LOW(chip8* c, const decoded* d);
+
+/*
+ * Show the hi-res screen, cleared.
+ */
+void HIGH(chip8* c, const decoded* d);
+
+/*
+ * Load location of the big sprite of the digit in Vx into I. Each big sprite
+ * has ten 8-bit rows, starting at BIG_FONT.
+ */
+void LDHF(chip8* c, const decoded* d);
 
 /*
- * Store all register values from V0 to Vx in memory starting at address I.
+ * Store registers V0 to Vx in the RPL user flags; x is at most 7.
  */
-void STA(instruction i);
+void STR(chip8* c, const decoded* d);
 
 /*
- * Load all register values from V0 to Vx from memory starting at address I.
+ * Load registers V0 to Vx from the RPL user flags; x is at most 7.
  */
-void LDA(instruction i);
+void LDRF(chip8* c, const decoded* d);
 
 #endif
@@ -0,0 +1,203 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Profile.h"
+
+#ifdef PROFILE
+/* Name of each OP_ operation */
+static const char* const _names[NUM_OPS] = {
+	"UNKNOWN", "CLS", "RET", "JP", "CALL", "SE", "SNEI", "SR", "LDB", "ADDI",
+	"LDR", "OR", "AND", "XOR", "ADD", "SUB", "SHR", "SUBN", "SHL", "SNE",
+	"LDI", "JPR", "RND", "DRW", "SKP", "SKNP", "LDD", "LDK", "STD", "STS",
+	"IINC", "LDF", "BCD", "STA", "LDA", "SCD", "SCR", "SCL", "EXIT", "LOW",
+	"HIGH", "DRWX", "LDHF", "STR", "LDRF"
+};
+
+/* Entry point of the program itself, the root of every call path */
+#define ENTRY 0x200
+
+/* One line of a histogram */
+typedef struct bar {
+	u_int64_t count;
+	u_int32_t key;
+} bar;
+
+static int _most_first(const void* a, const void* b)
+{
+	const bar* x = a;
+	const bar* y = b;
+
+	return x->count < y->count ? 1 : x->count > y->count ? -1
+		: (x->key > y->key) - (x->key < y->key);
+}
+
+void record_profile(chip8* c, address a, const decoded* d)
+{
+	profile* p = &c->prof;
+	profile_node* n;
+	u_int16_t id;
+
+	p->ops[d->op]++;
+	p->pcs[MEM(a)]++;
+	p->nodes[p->current].cycles++;
+
+	if (d->op == OP_CALL) {
+		/*
+		 * A call which overflows the stack is counted in its caller, as is
+		 * everything called within a call counted so
+		 */
+		if (p->untracked || c->sp < STACK_UP) {
+			p->untracked++;
+			return;
+		}
+		/* Follow the call onto its path, adding the path the first time */
+		for (id = p->nodes[p->current].child; id; id = p->nodes[id].sibling) {
+			if (p->nodes[id].entry == d->nnn) {
+				break;
+			}
+		}
+		if (!id && p->num_nodes < PROFILE_NODES) {
+			id = p->num_nodes++;
+			n = &p->nodes[id];
+			n->cycles = 0;
+			n->entry = d->nnn;
+			n->parent = p->current;
+			n->child = 0;
+			n->sibling = p->nodes[p->current].child;
+			p->nodes[p->current].child = id;
+		}
+		/*
+		 * Once out of paths, calls are counted in their caller, and so are
+		 * their returns
+		 */
+		if (id) {
+			p->current = id;
+		} else {
+			p->untracked++;
+		}
+	} else if (d->op == OP_RET) {
+		if (p->untracked) {
+			p->untracked--;
+		} else if (p->current) {
+			p->current = p->nodes[p->current].parent;
+		}
+	}
+}
+
+/*
+ * Return the instructions executed on path id of p and every path called from
+ * it, adding those executed inside each subroutine to totals by its entry
+ * point unless an outer call of the same subroutine already counts them.
+ */
+static u_int64_t _total(const profile* p, u_int16_t id, u_int64_t* totals)
+{
+	const profile_node* n = &p->nodes[id];
+	u_int64_t total = n->cycles;
+	u_int16_t up = id;
+	u_int16_t child;
+
+	for (child = n->child; child; child = p->nodes[child].sibling) {
+		total += _total(p, child, totals);
+	}
+	while (up) {
+		up = p->nodes[up].parent;
+		if (p->nodes[up].entry == n->entry) {
+			/* Recursive call, already counted by the outer one */
+			return total;
+		}
+	}
+	totals[n->entry] += total;
+	return total;
+}
+#endif
+
+void clear_profile(chip8* c)
+{
+#ifdef PROFILE
+	memset(&c->prof, 0, sizeof(profile));
+	c->prof.nodes[0].entry = ENTRY;
+	c->prof.num_nodes = 1;
+#endif
+}
+
+void dump_profile(const chip8* c, FILE* f)
+{
+#ifdef PROFILE
+	const profile* p = &c->prof;
+	u_int64_t* totals = calloc(SIZE_MEM, sizeof(u_int64_t));
+	bar* bars = malloc(SIZE_MEM * sizeof(bar));
+	u_int32_t n = 0;
+	u_int32_t j;
+
+	if (!totals || !bars) {
+		free(totals);
+		free(bars);
+		return;
+	}
+	for (j = 0; j < NUM_OPS; j++) {
+		if (p->ops[j]) {
+			bars[n].count = p->ops[j];
+			bars[n++].key = j;
+		}
+	}
+	qsort(bars, n, sizeof(bar), _most_first);
+	for (j = 0; j < n; j++) {
+		fprintf(f, "op %-7s %llu\n", _names[bars[j].key],
+			(unsigned long long) bars[j].count);
+	}
+
+	_total(p, 0, totals);
+	for (n = 0, j = 0; j < SIZE_MEM; j++) {
+		if (totals[j]) {
+			bars[n].count = totals[j];
+			bars[n++].key = j;
+		}
+	}
+	qsort(bars, n, sizeof(bar), _most_first);
+	for (j = 0; j < n; j++) {
+		fprintf(f, "sub 0x%03X %llu\n", bars[j].key,
+			(unsigned long long) bars[j].count);
+	}
+
+	for (n = 0, j = 0; j < SIZE_MEM; j++) {
+		if (p->pcs[j]) {
+			bars[n].count = p->pcs[j];
+			bars[n++].key = j;
+		}
+	}
+	qsort(bars, n, sizeof(bar), _most_first);
+	for (j = 0; j < n; j++) {
+		fprintf(f, "pc 0x%03X %llu\n", bars[j].key,
+			(unsigned long long) bars[j].count);
+	}
+	free(totals);
+	free(bars);
+#else
+	fprintf(f, "No profile recorded: compile with PROFILE defined\n");
+#endif
+}
+
+void dump_folded(const chip8* c, FILE* f)
+{
+#ifdef PROFILE
+	const profile* p = &c->prof;
+	u_int16_t path[PROFILE_NODES];
+	u_int16_t id;
+	u_int16_t up;
+	int depth;
+
+	for (id = 0; id < p->num_nodes; id++) {
+		if (!p->nodes[id].cycles) {
+			continue;
+		}
+		depth = 0;
+		for (up = id; up; up = p->nodes[up].parent) {
+			path[depth++] = up;
+		}
+		fprintf(f, "0x%03X", ENTRY);
+		while (depth--) {
+			fprintf(f, ";0x%03X", p->nodes[path[depth]].entry);
+		}
+		fprintf(f, " %llu\n", (unsigned long long) p->nodes[id].cycles);
+	}
+#endif
+}
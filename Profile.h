@@ -0,0 +1,67 @@
+/*
+ * Execution profiling for the CHIP-8 emulator.
+ *
+ * When compiled with PROFILE defined, every machine counts the instructions
+ * it executes: how often each operation ran, how often the instruction at
+ * each address ran, and how many instructions ran on each path of subroutine
+ * calls, following CALL and RET. Each path is named by the entry points of
+ * the subroutines called along it, so that time inside a subroutine is told
+ * apart by where it was called from. The profile can be written out as a
+ * histogram, or as folded stacks, one line per call path, which flame graph
+ * tools read directly.
+ *
+ * Without PROFILE defined, recording compiles to nothing and machines hold
+ * no profile at all.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+/* INCLUDE */
+#include <stdio.h>
+#include "InstructionSet.h"
+
+#ifdef PROFILE
+/* Count the instruction at address a, decoded as d, in the profile of c */
+#define PROFILE_RECORD(c, a, d) record_profile((c), (a), (d))
+
+/*
+ * Count the instruction at address a, decoded as d, which machine c is about
+ * to execute. Use PROFILE_RECORD rather than calling this directly.
+ */
+void record_profile(chip8* c, address a, const decoded* d);
+#else
+#define PROFILE_RECORD(c, a, d)
+#endif
+
+/* PROTOTYPES */
+/*
+ * Empty the profile of machine c.
+ */
+void clear_profile(chip8* c);
+
+/*
+ * Print the profile of machine c to f as a histogram: one line per operation,
+ * then per subroutine entry point with the instructions executed inside it
+ * and its callees, then per address, each with its count and most executed
+ * first. Nothing which never executed is printed.
+ *
+ * Without PROFILE defined, prints that no profile was recorded.
+ */
+void dump_profile(const chip8* c, FILE* f);
+
+/*
+ * Print the call paths of the profile of machine c to f as folded stacks:
+ * one line per path, the path's subroutines from the outermost separated by
+ * ';', then the number of instructions executed on the path itself.
+ *
+ * Without PROFILE defined, prints nothing.
+ */
+void dump_folded(const chip8* c, FILE* f);
+
+#endif
@@ -0,0 +1,291 @@
+/*
+ * Template of the methods of one quirk profile, see Quirks.h.
+ *
+ * Included by Quirks.c once per profile, with the profile's parameters
+ * defined beforehand:
+ *     QUIRK_SUFFIX    suffix of every name the profile defines
+ *     QUIRK_NAME      name of the profile, a string
+ *     QUIRK_SHIFT_VY  1 if SHR and SHL shift Vy into Vx, 0 if they shift Vx
+ *     QUIRK_ADVANCE_I 1 if STA and LDA leave I past the last register
+ *     QUIRK_JUMP_VX   1 if JPR adds Vx, 0 if it adds V0
+ *     QUIRK_CLIP      1 if DRW clips sprites at the edges, 0 if it wraps them
+ * Each inclusion defines static methods for the instructions the profile
+ * changes, a handler table, run loops, and the quirk_profile _profile_SUFFIX
+ * holding them, then undefines the parameters for the next profile. There is
+ * no include guard.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+
+/* INCLUDE */
+#include "Profile.h"
+#include "Quirks.h"
+#include "Trace.h"
+
+/* DEFINE */
+#ifndef QUIRKED
+#define QUIRK_PASTE(name, suffix) name##_##suffix
+#define QUIRK_EXPAND(name, suffix) QUIRK_PASTE(name, suffix)
+/* Name of something of the profile being compiled */
+#define QUIRKED(name) QUIRK_EXPAND(name, QUIRK_SUFFIX)
+#endif
+
+/* Register SHR and SHL shift */
+#if QUIRK_SHIFT_VY
+#define QUIRK_SOURCE d->y
+#else
+#define QUIRK_SOURCE d->x
+#endif
+
+/*
+ * Perform one unsigned right shift on the value in Vy, or in Vx; store in Vx.
+ * VF is set to the least significant bit of the value shifted.
+ */
+static void QUIRKED(_SHR)(chip8* c, const decoded* d)
+{
+	c->v[0xF] = LSBI(c->v[QUIRK_SOURCE]);
+	c->v[d->x] = c->v[QUIRK_SOURCE] >> 1;
+}
+
+/*
+ * Perform one left shift on the value in Vy, or in Vx; store in Vx. VF is set
+ * to the most significant bit of the value shifted.
+ */
+static void QUIRKED(_SHL)(chip8* c, const decoded* d)
+{
+	c->v[0xF] = MSBR(c->v[QUIRK_SOURCE]);
+	c->v[d->x] = c->v[QUIRK_SOURCE] << 1;
+}
+
+/*
+ * Set PC to least significant three nibbles of instruction + value in V0, or
+ * in Vx, x being the most significant of those nibbles.
+ */
+static void QUIRKED(_JPR)(chip8* c, const decoded* d)
+{
+#if QUIRK_JUMP_VX
+	c->PC = d->nnn + c->v[d->x];
+#else
+	c->PC = d->nnn + c->v[0x0];
+#endif
+}
+
+/*
+ * Return row y of the sprite at I, width pixels (8 or 16) wide, in its
+ * bottom width bits.
+ */
+static inline u_int64_t QUIRKED(_sprite)(const chip8* c, int y, int width)
+{
+	if (width == 16) {
+		return INSTR(c->RAM[MEM(c->I + 2 * y)], c->RAM[MEM(c->I + 2 * y + 1)]);
+	}
+	return c->RAM[MEM(c->I + y)];
+}
+
+/*
+ * Draw the height rows of the sprite at I, width pixels (8 or 16) wide, onto
+ * the hi-res screen at location (Vx, Vy), setting VF = collision.
+ *
+ * A sprite row spans at most two words of a screen row: it is shifted into
+ * place across them, which takes two ANDs and two XORs whatever its width.
+ */
+static inline void QUIRKED(_draw_hires)(chip8* c, const decoded* d,
+	int height, int width)
+{
+	int y, k;
+	int r;
+	u_int64_t bits;
+	u_int64_t left;
+	u_int64_t right;
+	u_int64_t* row;
+	u_int64_t collision = 0;
+	u_int8_t Vx = c->v[d->x] % HIRES_WIDTH;
+	u_int8_t Vy = c->v[d->y] % HIRES_HEIGHT;
+	int word = Vx / 64;
+	int shift = Vx % 64;
+
+#if QUIRK_CLIP
+	if (height > HIRES_HEIGHT - Vy) {
+		height = HIRES_HEIGHT - Vy;
+	}
+#endif
+	for (y = 0; y < height; y++) {
+		r = (Vy + y) % HIRES_HEIGHT;
+		bits = QUIRKED(_sprite)(c, y, width) << (64 - width);
+		left = bits >> shift;
+		right = shift ? bits << (64 - shift) : 0;
+		k = word + 1;
+		if (k == HIRES_WORDS) {
+			/* Past the right edge */
+#if QUIRK_CLIP
+			right = 0;
+#endif
+			k = 0;
+		}
+		row = HIRES_ROW(c, r);
+		collision |= (row[word] & left) | (row[k] & right);
+		row[word] ^= left;
+		row[k] ^= right;
+		c->dirty |= 1ULL << r;
+	}
+	c->v[0xF] = collision ? 1 : 0;
+	c->draw = 1;
+}
+
+/*
+ * Draw the height rows of the sprite at I, width pixels (8 or 16) wide, onto
+ * the screen shown at location (Vx, Vy), setting VF = collision. The draw flag
+ * is set to 1 to signal to the front end to refresh the screen.
+ *
+ * Each sprite row is shifted into place within a whole screen row, so drawing
+ * it takes one AND to check for collision and one XOR. The location wraps
+ * around the screen; the parts of the sprite past the right and bottom edges
+ * wrap around too, or are clipped. Every row drawn to is marked as dirty.
+ */
+static inline void QUIRKED(_draw)(chip8* c, const decoded* d, int height,
+	int width)
+{
+	int y;
+	int r;
+	u_int64_t row;
+	u_int64_t collision = 0;
+	u_int8_t Vx = c->v[d->x] % WIDTH;
+	u_int8_t Vy = c->v[d->y] % HEIGHT;
+
+	if (c->hires) {
+		QUIRKED(_draw_hires)(c, d, height, width);
+		return;
+	}
+#if QUIRK_CLIP
+	if (height > HEIGHT - Vy) {
+		height = HEIGHT - Vy;
+	}
+#endif
+	for (y = 0; y < height; y++) {
+		r = (Vy + y) % HEIGHT;
+		row = QUIRKED(_sprite)(c, y, width) << (WIDTH - width);
+#if QUIRK_CLIP
+		row >>= Vx;
+#else
+		row = ROTR(row, Vx);
+#endif
+		collision |= c->screen[r] & row;
+		c->screen[r] ^= row;
+		c->dirty |= 1ULL << r;
+	}
+	c->v[0xF] = collision ? 1 : 0;
+	c->draw = 1;
+}
+
+/*
+ * Draw the n-byte sprite at I, 8 pixels wide, onto the screen at location
+ * (Vx, Vy), set VF = collision.
+ */
+static void QUIRKED(_DRW)(chip8* c, const decoded* d)
+{
+	QUIRKED(_draw)(c, d, d->n, 8);
+}
+
+/*
+ * Draw the 16 x 16 sprite at I, two bytes per row, onto the screen at
+ * location (Vx, Vy), set VF = collision.
+ */
+static void QUIRKED(_DRWX)(chip8* c, const decoded* d)
+{
+	QUIRKED(_draw)(c, d, 16, 16);
+}
+
+/*
+ * Store all register values from V0 to Vx in memory starting at address I,
+ * then advance I past them if the profile does.
+ */
+static void QUIRKED(_STA)(chip8* c, const decoded* d)
+{
+	for (int j = 0; j <= d->x; j++) {
+		write_mem(c, c->I + j, c->v[j]);
+	}
+#if QUIRK_ADVANCE_I
+	c->I += d->x + 1;
+#endif
+}
+
+/*
+ * Load all register values from V0 to Vx from memory starting at address I,
+ * then advance I past them if the profile does.
+ */
+static void QUIRKED(_LDA)(chip8* c, const decoded* d)
+{
+	for (int j = 0; j <= d->x; j++) {
+		c->v[j] = c->RAM[MEM(c->I + j)];
+	}
+#if QUIRK_ADVANCE_I
+	c->I += d->x + 1;
+#endif
+}
+
+/* Method executing each operation in this profile, indexed by OP_ value */
+static const handler QUIRKED(_handlers)[NUM_OPS] = {
+	UNKNOWN, CLS, RET, JP, CALL, SE, SNEI, SR, LDB, ADDI, LDR, OR, AND, XOR,
+	ADD, SUB, QUIRKED(_SHR), SUBN, QUIRKED(_SHL), SNE, LDI, QUIRKED(_JPR), RND,
+	QUIRKED(_DRW), SKP, SKNP, LDD, LDK, STD, STS, IINC, LDF, BCD,
+	QUIRKED(_STA), QUIRKED(_LDA), SCD, SCR, SCL, EXIT, LOW, HIGH,
+	QUIRKED(_DRWX), LDHF, STR, LDRF
+};
+
+/*
+ * Execute up to n instructions on machine c, fetching and decoding each one.
+ */
+static u_int32_t QUIRKED(_run_interp)(chip8* c, u_int32_t n)
+{
+	u_int32_t executed = 0;
+	decoded d;
+
+	while (executed < n && !c->halt && !c->idle) {
+		predecode(fetch(c), &d);
+		TRACE_RECORD(c, c->PC - 2, &d);
+		PROFILE_RECORD(c, c->PC - 2, &d);
+		QUIRKED(_handlers)[d.op](c, &d);
+		executed++;
+	}
+	return executed;
+}
+
+/*
+ * Execute up to n instructions on machine c from its predecoded instruction
+ * cache, decoding instructions into the cache the first time they're reached.
+ */
+static u_int32_t QUIRKED(_run_cached)(chip8* c, u_int32_t n)
+{
+	u_int32_t executed = 0;
+	decoded* d;
+
+	while (executed < n && !c->halt && !c->idle) {
+		d = &c->cache[MEM(c->PC)];
+		if (d->op == OP_NONE) {
+			predecode(INSTR(c->RAM[MEM(c->PC)], c->RAM[MEM(c->PC + 1)]), d);
+		}
+		TRACE_RECORD(c, c->PC, d);
+		PROFILE_RECORD(c, c->PC, d);
+		c->PC += 2;
+		QUIRKED(_handlers)[d->op](c, d);
+		executed++;
+	}
+	return executed;
+}
+
+static const quirk_profile QUIRKED(_profile) = {
+	QUIRK_NAME, QUIRK_SHIFT_VY, QUIRK_ADVANCE_I, QUIRK_JUMP_VX, QUIRK_CLIP,
+	QUIRKED(_handlers), QUIRKED(_run_interp), QUIRKED(_run_cached)
+};
+
+#undef QUIRK_SOURCE
+#undef QUIRK_SUFFIX
+#undef QUIRK_NAME
+#undef QUIRK_SHIFT_VY
+#undef QUIRK_ADVANCE_I
+#undef QUIRK_JUMP_VX
+#undef QUIRK_CLIP
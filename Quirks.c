@@ -0,0 +1,86 @@
+#include <string.h>
+#include "BlockEngine.h"
+#include "Quirks.h"
+
+#define QUIRK_SUFFIX    default
+#define QUIRK_NAME      "default"
+#define QUIRK_SHIFT_VY  0
+#define QUIRK_ADVANCE_I 0
+#define QUIRK_JUMP_VX   0
+#define QUIRK_CLIP      0
+#include "QuirkTemplate.h"
+
+#define QUIRK_SUFFIX    vip
+#define QUIRK_NAME      "vip"
+#define QUIRK_SHIFT_VY  1
+#define QUIRK_ADVANCE_I 1
+#define QUIRK_JUMP_VX   0
+#define QUIRK_CLIP      1
+#include "QuirkTemplate.h"
+
+#define QUIRK_SUFFIX    schip
+#define QUIRK_NAME      "schip"
+#define QUIRK_SHIFT_VY  0
+#define QUIRK_ADVANCE_I 0
+#define QUIRK_JUMP_VX   1
+#define QUIRK_CLIP      1
+#include "QuirkTemplate.h"
+
+const quirk_profile* const quirk_profiles[NUM_QUIRKS] = {
+	[QUIRKS_DEFAULT] = &_profile_default,
+	[QUIRKS_VIP] = &_profile_vip,
+	[QUIRKS_SCHIP] = &_profile_schip
+};
+
+void set_quirks(chip8* c, u_int8_t quirks)
+{
+	if (quirks == QUIRKS_AUTO) {
+		quirks = detect_quirks(c);
+	}
+	c->quirks = quirks;
+	c->handlers = quirk_profiles[quirks]->handlers;
+	/* Translated blocks hold the methods of the previous profile */
+	flush_blocks(c);
+}
+
+u_int8_t detect_quirks(const chip8* c)
+{
+	static const instruction only_schip[][2] = {
+		/* instruction & mask == value */
+		{ 0xFFF0, 0x00C0 }, { 0xFFFF, 0x00FB }, { 0xFFFF, 0x00FC },
+		{ 0xFFFF, 0x00FD }, { 0xFFFF, 0x00FE }, { 0xFFFF, 0x00FF },
+		{ 0xF0FF, 0xF030 }, { 0xF0FF, 0xF075 }, { 0xF0FF, 0xF085 }
+	};
+	int kinds = sizeof(only_schip) / sizeof(only_schip[0]);
+	u_int16_t found = 0;
+	instruction i;
+	address a;
+	int k;
+
+	for (a = 0x200; a < STACK_UP; a += 2) {
+		i = INSTR(c->RAM[a], c->RAM[a + 1]);
+		for (k = 0; k < kinds; k++) {
+			/* 00C0 scrolls by no rows, so isn't one of them */
+			if ((i & only_schip[k][0]) == only_schip[k][1] && i != 0x00C0) {
+				found |= 1 << k;
+			}
+		}
+	}
+	/* At least two different ones */
+	return found & (found - 1) ? QUIRKS_SCHIP : QUIRKS_DEFAULT;
+}
+
+int find_quirks(const char* name)
+{
+	int q;
+
+	if (!strcmp(name, "auto")) {
+		return QUIRKS_AUTO;
+	}
+	for (q = 0; q < NUM_QUIRKS; q++) {
+		if (!strcmp(name, quirk_profiles[q]->name)) {
+			return q;
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,78 @@
+/*
+ * Quirk profiles of the CHIP-8 emulator.
+ *
+ * CHIP-8 interpreters disagree on a handful of instructions, and ROMs are
+ * written against whichever interpreter their authors used:
+ *     SHR, SHL  shift Vy into Vx, or shift Vx in place
+ *     STA, LDA  leave I past the last register stored or loaded, or leave it
+ *     JPR       jump to nnn + V0, or to xnn + Vx
+ *     DRW       wrap sprites around the edges of the screen, or clip them
+ * A quirk profile fixes the behaviour of each of these. Rather than checking
+ * the profile on every instruction, every profile is compiled separately from
+ * QuirkTemplate.h into its own methods for these instructions, its own
+ * handler table, and its own run loops for ENGINE_INTERP and ENGINE_CACHE,
+ * none of which test a quirk at run time. Selecting a profile only points
+ * the machine at the handler table and run loops of that profile. The
+ * SUPER-CHIP instructions themselves run under every profile.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef QUIRKS_H_
+#define QUIRKS_H_
+
+/* INCLUDE */
+#include "CHIP8Emulator.h"
+
+/* DEFINE */
+#define QUIRKS_DEFAULT 0    // shift Vx, keep I, jump by V0, wrap sprites
+#define QUIRKS_VIP     1    // COSMAC VIP: shift Vy, advance I, jump by V0, clip
+#define QUIRKS_SCHIP   2    // SUPER-CHIP: shift Vx, keep I, jump by Vx, clip
+#define NUM_QUIRKS     3    // number of quirk profiles
+#define QUIRKS_AUTO    0xFF // pick the profile from the ROM, see detect_quirks
+
+/* TYPEDEFS */
+/* One quirk profile and the methods compiled for it */
+typedef struct quirk_profile {
+	const char* name;       // name of the profile, as given on the command line
+	u_int8_t shift_vy;      // SHR and SHL shift Vy into Vx instead of Vx
+	u_int8_t advance_i;     // STA and LDA leave I past the last register
+	u_int8_t jump_vx;       // JPR adds Vx rather than V0
+	u_int8_t clip;          // DRW clips sprites at the edges instead of wrapping
+	const handler* handlers; // method executing each operation, by OP_ value
+	u_int32_t (*run_interp)(chip8* c, u_int32_t n); // ENGINE_INTERP run loop
+	u_int32_t (*run_cached)(chip8* c, u_int32_t n); // ENGINE_CACHE run loop
+} quirk_profile;
+
+/* Every quirk profile, indexed by QUIRKS_ value */
+extern const quirk_profile* const quirk_profiles[NUM_QUIRKS];
+
+/* PROTOTYPES */
+/*
+ * Select the quirk profile of machine c, one of the QUIRKS_ values. With
+ * QUIRKS_AUTO, the profile is picked by detect_quirks from the ROM already
+ * loaded into c. Any translated blocks of c are discarded.
+ */
+void set_quirks(chip8* c, u_int8_t quirks);
+
+/*
+ * Guess which quirk profile the ROM loaded into machine c was written for.
+ *
+ * Memory from 0x200 up to the stack is searched, an instruction at a time, for
+ * the instructions only SUPER-CHIP defines (00Cn, 00FB, 00FC, 00FD, 00FE, 00FF,
+ * Fx30, Fx75 and Fx85). A ROM holding at least two different ones, which
+ * sprite data alone rarely does, is taken to be a SUPER-CHIP ROM and gets
+ * QUIRKS_SCHIP; any other QUIRKS_DEFAULT.
+ */
+u_int8_t detect_quirks(const chip8* c);
+
+/*
+ * Return the QUIRKS_ value named name (the name of a profile, or "auto" for
+ * QUIRKS_AUTO), or -1 if there is none.
+ */
+int find_quirks(const char* name);
+
+#endif
@@ -0,0 +1,186 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Rewind.h"
+
+/* State to encode keyframes against */
+static const u_int8_t _zero[STATE_SIZE];
+
+/*
+ * Encode state a XORed with state b into out as runs: the number of unchanged
+ * bytes to skip and the number of changed bytes which follow, one 16-bit word
+ * each, then the changed bytes XORed. Returns the number of bytes written; out
+ * must hold at least 2 * STATE_SIZE bytes.
+ */
+static u_int32_t _encode(const u_int8_t* a, const u_int8_t* b, u_int8_t* out)
+{
+	u_int32_t i = 0;
+	u_int32_t length = 0;
+	u_int32_t start;
+	u_int32_t j;
+	u_int32_t same;
+	u_int16_t skip;
+	u_int16_t count;
+
+	while (i < STATE_SIZE) {
+		start = i;
+		while (i < STATE_SIZE && a[i] == b[i]) {
+			i++;
+		}
+		if (i == STATE_SIZE) {
+			break;
+		}
+		skip = i - start;
+
+		/* Changed bytes run on over gaps too short to be worth skipping */
+		for (j = i; j < STATE_SIZE; j += same) {
+			while (j < STATE_SIZE && a[j] != b[j]) {
+				j++;
+			}
+			same = 0;
+			while (j + same < STATE_SIZE && same < MIN_RUN
+				&& a[j + same] == b[j + same]) {
+				same++;
+			}
+			if (same == MIN_RUN || j + same == STATE_SIZE) {
+				break;
+			}
+		}
+		count = j - i;
+
+		memcpy(out + length, &skip, sizeof(skip));
+		memcpy(out + length + sizeof(skip), &count, sizeof(count));
+		length += sizeof(skip) + sizeof(count);
+		for (; i < j; i++) {
+			out[length++] = a[i] ^ b[i];
+		}
+	}
+	return length;
+}
+
+/*
+ * XOR the state encoded in the length bytes at in into state.
+ */
+static void _decode(u_int8_t* state, const u_int8_t* in, u_int32_t length)
+{
+	u_int32_t i = 0;
+	u_int32_t at = 0;
+	u_int16_t skip;
+	u_int16_t count;
+
+	while (i < length) {
+		memcpy(&skip, in + i, sizeof(skip));
+		memcpy(&count, in + i + sizeof(skip), sizeof(count));
+		i += sizeof(skip) + sizeof(count);
+		for (at += skip; count; count--) {
+			state[at++] ^= in[i++];
+		}
+	}
+}
+
+/*
+ * Drop the oldest keyframe of r and every state encoded against it.
+ */
+static void _evict(rewinder* r)
+{
+	if (r->first == r->key) {
+		r->first = r->next;
+		return;
+	}
+	do {
+		r->first++;
+	} while (!r->entries[r->first % REWIND_FRAMES].keyframe);
+	r->tail = r->entries[r->first % REWIND_FRAMES].offset;
+}
+
+/*
+ * Find room for length bytes in the pool of r and point head at it. Returns 0
+ * if the oldest states must be dropped first.
+ */
+static int _reserve(rewinder* r, u_int32_t length)
+{
+	if (r->first == r->next) {
+		r->head = r->tail = 0;
+		return 1;
+	}
+	if (r->head < r->tail) {
+		return r->tail - r->head > length;
+	}
+	if (REWIND_POOL - r->head >= length) {
+		return 1;
+	}
+	/* Wrap around to the start of the pool */
+	if (r->tail > length) {
+		r->head = 0;
+		return 1;
+	}
+	return 0;
+}
+
+rewinder* alloc_rewind(void)
+{
+	return calloc(1, sizeof(rewinder));
+}
+
+void record_frame(rewinder* r, const chip8* c)
+{
+	u_int8_t* out = r->scratch;
+	save_state s;
+	rewind_entry* e;
+	u_int32_t length;
+	int keyframe;
+
+	save_machine(c, &s);
+	keyframe = r->first == r->next || r->next - r->key >= KEY_INTERVAL;
+	for (;;) {
+		length = _encode(s.data, keyframe ? _zero : r->key_state.data, out);
+		if (r->next - r->first < REWIND_FRAMES && _reserve(r, length)) {
+			break;
+		}
+		_evict(r);
+		/* Nothing is left to encode against once the keyframe was dropped */
+		if (r->first == r->next) {
+			keyframe = 1;
+		}
+	}
+
+	memcpy(r->pool + r->head, out, length);
+	e = &r->entries[r->next % REWIND_FRAMES];
+	e->offset = r->head;
+	e->length = length;
+	e->keyframe = keyframe;
+	r->head += length;
+	if (keyframe) {
+		r->key = r->next;
+		r->key_state = s;
+	}
+	r->next++;
+}
+
+int rewind_frame(rewinder* r, chip8* c)
+{
+	save_state s;
+	const rewind_entry* e;
+
+	if (r->first == r->next) {
+		return -1;
+	}
+	r->next--;
+	e = &r->entries[r->next % REWIND_FRAMES];
+	s = r->key_state;
+	if (!e->keyframe) {
+		_decode(s.data, r->pool + e->offset, e->length);
+	}
+	restore_machine(c, &s);
+	r->head = e->offset;
+
+	/* Further frames are encoded against the keyframe before this one */
+	if (e->keyframe && r->first != r->next) {
+		do {
+			r->key--;
+		} while (!r->entries[r->key % REWIND_FRAMES].keyframe);
+		e = &r->entries[r->key % REWIND_FRAMES];
+		memset(r->key_state.data, 0, STATE_SIZE);
+		_decode(r->key_state.data, r->pool + e->offset, e->length);
+	}
+	return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * Rewind buffer for the CHIP-8 emulator.
+ *
+ * A rewinder records the state of a machine (see SaveState.h) once per frame
+ * and can step it back through those states, latest first. States are not
+ * stored whole: every KEY_INTERVAL frames a keyframe is taken, and every
+ * other frame only stores how its state differs from the latest keyframe.
+ * The difference is the state XORed with the keyframe, which is zero wherever
+ * RAM, the screen and the registers did not change, with the runs of zeros
+ * then left out. Keyframes are encoded the same way against an all-zero
+ * state, which drops the unused parts of RAM.
+ *
+ * Encoded states are kept in a fixed pool of REWIND_POOL bytes used as a ring.
+ * When the pool or the REWIND_FRAMES entries run out, the oldest keyframe and
+ * every state encoded against it are dropped together, so the rewinder always
+ * holds the most recent states that fit.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef REWIND_H_
+#define REWIND_H_
+
+/* INCLUDE */
+#include "CHIP8Emulator.h"
+#include "SaveState.h"
+
+/* DEFINE */
+#define REWIND_FRAMES (FRAME_RATE * 60 * 3) // at most 3 minutes of states
+#define REWIND_POOL (256 * 1024)            // bytes of encoded states
+#define KEY_INTERVAL FRAME_RATE             // frames between two keyframes
+#define MIN_RUN 4 // shortest run of unchanged bytes worth leaving out
+
+/* TYPEDEFS */
+/* Location of one encoded state in the pool */
+typedef struct rewind_entry {
+	u_int32_t offset;  // first byte of the state in the pool
+	u_int16_t length;  // number of bytes the state was encoded into
+	u_int16_t keyframe; // encoded against zero (1) or the keyframe (0)
+} rewind_entry;
+
+typedef struct rewinder {
+	unsigned long first; // oldest frame held, always a keyframe
+	unsigned long next;  // number of frames ever recorded
+	unsigned long key;   // latest keyframe held
+	u_int32_t head;      // where the next state is written in the pool
+	u_int32_t tail;      // where the oldest state begins in the pool
+	save_state key_state; // state of the latest keyframe
+	rewind_entry entries[REWIND_FRAMES]; // frame f held at f % REWIND_FRAMES
+	u_int8_t scratch[2 * STATE_SIZE];    // state being encoded
+	u_int8_t pool[REWIND_POOL];
+} rewinder;
+
+/* PROTOTYPES */
+/*
+ * Allocate an empty rewinder. Returns NULL if there isn't enough memory.
+ */
+rewinder* alloc_rewind(void);
+
+/*
+ * Record the state of machine c as the latest frame of r.
+ */
+void record_frame(rewinder* r, const chip8* c);
+
+/*
+ * Restore machine c to the latest frame recorded in r and drop that frame, so
+ * that calling this again steps further back.
+ *
+ * Returns -1 without changing c if r holds no frames, 0 otherwise.
+ */
+int rewind_frame(rewinder* r, chip8* c);
+
+#endif
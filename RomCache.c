@@ -0,0 +1,103 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CHIP8Emulator.h"
+#include "RomCache.h"
+
+static rom_image* _roms = NULL;
+static pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * FNV-1a hash of the first size bytes at data, padded with zeros to MAX_ROM.
+ */
+static u_int64_t _hash(const u_int8_t* data, size_t size)
+{
+	u_int64_t hash = 0xCBF29CE484222325ULL;
+	size_t j;
+
+	for (j = 0; j < MAX_ROM; j++) {
+		hash = (hash ^ (j < size ? data[j] : 0)) * 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+/*
+ * Map the file at path into a new image. Returns NULL after printing the
+ * error if it can't be.
+ */
+static rom_image* _map(const char* path)
+{
+	rom_image* r;
+	struct stat st;
+	void* data;
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0) {
+		printf("ROM %s not found\n", path);
+		return NULL;
+	}
+	if (fstat(fd, &st) || st.st_size <= 0) {
+		printf("Error reading ROM %s\n", path);
+		close(fd);
+		return NULL;
+	}
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	r = malloc(sizeof(rom_image));
+	if (data == MAP_FAILED || !r || !(r->path = strdup(path))) {
+		printf("Error reading ROM %s\n", path);
+		if (data != MAP_FAILED) {
+			munmap(data, st.st_size);
+		}
+		free(r);
+		return NULL;
+	}
+	r->data = data;
+	r->size = st.st_size;
+	r->hash = _hash(r->data, r->size);
+	return r;
+}
+
+const rom_image* open_rom(const char* path)
+{
+	rom_image* r;
+
+	pthread_mutex_lock(&_lock);
+	for (r = _roms; r && strcmp(r->path, path); r = r->next);
+	if (!r && (r = _map(path))) {
+		r->next = _roms;
+		_roms = r;
+	}
+	pthread_mutex_unlock(&_lock);
+	return r;
+}
+
+u_int64_t hash_rom(const chip8* c)
+{
+	return _hash(c->RAM + ROM_START, MAX_ROM);
+}
+
+void copy_rom(chip8* c, const rom_image* r)
+{
+	memcpy(c->RAM + ROM_START, r->data, r->size < MAX_ROM ? r->size : MAX_ROM);
+	flush_cache(c);
+}
+
+void close_roms()
+{
+	rom_image* r;
+
+	pthread_mutex_lock(&_lock);
+	while ((r = _roms)) {
+		_roms = r->next;
+		munmap((void*) r->data, r->size);
+		free(r->path);
+		free(r);
+	}
+	pthread_mutex_unlock(&_lock);
+}
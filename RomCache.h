@@ -0,0 +1,67 @@
+/*
+ * Registry of ROM images for the CHIP-8 emulator.
+ *
+ * The first time a ROM is asked for, its file is memory-mapped and kept
+ * for the rest of the process; every later load of the same path only copies
+ * the mapped image into the machine's RAM, without touching the file system.
+ * Batches which start the same ROMs many times over therefore read each file
+ * once. Each image also carries a hash of its bytes so that anything derived
+ * from a ROM can be keyed by its contents rather than its path.
+ *
+ * The registry is shared by every thread; images are never unmapped before
+ * close_roms, so pointers to them stay valid until then.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef ROMCACHE_H_
+#define ROMCACHE_H_
+
+/* INCLUDE */
+#include <stddef.h>
+#include "InstructionSet.h"
+
+/* DEFINE */
+#define ROM_START 0x200 // address ROMs are loaded at
+#define MAX_ROM   0xCA0 // most bytes of a ROM loaded, up to where the stack begins
+
+/* TYPEDEFS */
+typedef struct rom_image {
+	char* path;             // path the ROM was opened by
+	const u_int8_t* data;   // mapped contents of the file
+	size_t size;            // bytes in the file
+	u_int64_t hash;         // hash_rom of the ROM once loaded into RAM
+	struct rom_image* next; // next image in the registry
+} rom_image;
+
+/* PROTOTYPES */
+/*
+ * Return the image of the ROM at path, mapping the file the first time.
+ *
+ * Returns NULL after printing the error if the file can't be opened, is empty,
+ * or can't be mapped.
+ */
+const rom_image* open_rom(const char* path);
+
+/*
+ * Return the FNV-1a hash of the MAX_ROM bytes of memory at ROM_START of
+ * machine c, which is the hash of the image of a ROM just loaded into c.
+ */
+u_int64_t hash_rom(const chip8* c);
+
+/*
+ * Copy the first MAX_ROM bytes of image r into the RAM of machine c at
+ * ROM_START, then flush c's caches.
+ */
+void copy_rom(chip8* c, const rom_image* r);
+
+/*
+ * Unmap every image in the registry. Images returned by open_rom must not be
+ * used afterwards.
+ */
+void close_roms();
+
+#endif
@@ -0,0 +1,511 @@
+#ifndef NO_SDL
+#include <SDL/SDL.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "SDLFrontend.h"
+#include "Audio.h"
+#include "Display.h"
+#include "GLDisplay.h"
+#include "Rewind.h"
+#include "SaveState.h"
+#include "Scheduler.h"
+#include "Trace.h"
+#include "TripleBuffer.h"
+
+u_int8_t emulator_keys[NUM_KEYS] = {
+	SDLK_x, SDLK_1, SDLK_2, SDLK_3, SDLK_q, SDLK_w, SDLK_e, SDLK_a,
+	SDLK_s, SDLK_d, SDLK_z, SDLK_c, SDLK_4, SDLK_r, SDLK_f, SDLK_v
+};
+
+#define MAX_TRANSITIONS 64 // key changes held between two frames
+
+/* Commands from the render thread to the emulation thread, one bit each */
+#define CMD_TRACE   1  // print the trace
+#define CMD_SAVE    2  // save the machine to the quick save slot
+#define CMD_RESTORE 4  // restore the quick save slot
+#define CMD_TURBO   8  // toggle turbo mode
+#define CMD_QUIT    16 // end the emulator
+
+/* Change of one emulator key, with the time it happened */
+typedef struct key_transition {
+	u_int64_t time; // monotonic time of the change
+	u_int8_t key;   // CHIP-8 key which changed
+	u_int8_t down;  // key was pressed (1) or released (0)
+} key_transition;
+
+/* Key changes held for the front end between two frames */
+static struct {
+	key_transition ring[MAX_TRANSITIONS]; // changes recorded by _filter
+	atomic_uint head;                     // number of changes ever recorded
+	atomic_uint tail;                     // number of changes ever taken
+} _transitions;
+
+/* Latched input of the front end */
+typedef struct input {
+	u_int16_t mask;                          // keys held down
+	key_transition pending[MAX_TRANSITIONS]; // changes still to apply
+	u_int32_t count;                         // number of pending changes
+	u_int32_t next;                          // next pending change to apply
+	u_int64_t from;                          // when the changes began
+	u_int64_t to;                            // when they were taken
+} input;
+
+/* Everything the emulation and render threads share */
+typedef struct shared {
+	chip8* c;                      // machine, only touched by emulation
+	const frontend_config* config;
+	triple_buffer frames;          // screens from emulation to render
+	atomic_uint keys;              // keys held down, from render to emulation
+	atomic_uint commands;          // CMD_ bits, from render to emulation
+	atomic_uchar rewinding;        // Backspace is held down
+	atomic_int status;             // exit status plus 1 once emulation ended
+	u_int8_t opengl;               // screen is presented through OpenGL
+} shared;
+
+/* Quick save slot, filled by F5 and restored by F9 */
+static save_state _slot;
+static u_int8_t _saved;
+
+/*
+ * Return the CHIP-8 key which emulator key sym stands for; -1 if none.
+ */
+static int _chip8_key(SDLKey sym)
+{
+	int i;
+
+	for (i = 0; i < NUM_KEYS; i++) {
+		if (emulator_keys[i] == sym) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*
+ * Event filter recording with a timestamp every change of an emulator key as
+ * soon as SDL receives it, instead of letting it wait in the event queue.
+ */
+static int _filter(const SDL_Event* e)
+{
+	unsigned head;
+	int key;
+
+	if (e->type != SDL_KEYDOWN && e->type != SDL_KEYUP) {
+		return 1;
+	}
+	key = _chip8_key(e->key.keysym.sym);
+	head = atomic_load(&_transitions.head);
+	if (key < 0 || head - atomic_load(&_transitions.tail) == MAX_TRANSITIONS) {
+		return 1;
+	}
+	_transitions.ring[head % MAX_TRANSITIONS].time = monotonic_ns();
+	_transitions.ring[head % MAX_TRANSITIONS].key = key;
+	_transitions.ring[head % MAX_TRANSITIONS].down = e->type == SDL_KEYDOWN;
+	atomic_store(&_transitions.head, head + 1);
+	return 0;
+}
+
+/*
+ * Drain the event queue on the render thread: pass the keys of the front end
+ * itself on to the emulation thread as commands, and which emulator keys are
+ * held down as a key mask. Key changes the event filter recorded never reach
+ * the queue.
+ */
+static void _poll_events(shared* sh)
+{
+	SDL_Event e;
+	unsigned keys = atomic_load(&sh->keys);
+	unsigned commands = 0;
+	int key;
+
+	while (SDL_PollEvent(&e)) {
+		if (e.type == SDL_QUIT) {
+			commands |= CMD_QUIT;
+		}
+#ifdef OPENGL
+		if (e.type == SDL_VIDEORESIZE && sh->opengl) {
+			resize_gl_display(e.resize.w, e.resize.h);
+		}
+#endif
+		if (e.type != SDL_KEYDOWN && e.type != SDL_KEYUP) {
+			continue;
+		}
+		if (e.type == SDL_KEYDOWN) {
+			switch (e.key.keysym.sym) {
+				case SDLK_ESCAPE:
+					commands |= CMD_QUIT;
+					break;
+				case SDLK_F1:
+					/* F1 dumps the trace on demand */
+					commands |= CMD_TRACE;
+					break;
+				case SDLK_F5:
+					/* F5 saves the machine to the quick save slot */
+					commands |= CMD_SAVE;
+					break;
+				case SDLK_F9:
+					/* F9 restores the quick save slot, if anything is saved */
+					commands |= CMD_RESTORE;
+					break;
+				case SDLK_TAB:
+					/* Tab toggles turbo mode */
+					commands ^= CMD_TURBO;
+					break;
+				default:
+					break;
+			}
+		}
+		if (e.key.keysym.sym == SDLK_BACKSPACE) {
+			/* Backspace held down steps back a frame every frame */
+			atomic_store(&sh->rewinding, e.type == SDL_KEYDOWN);
+		}
+		key = _chip8_key(e.key.keysym.sym);
+		if (key >= 0) {
+			if (e.type == SDL_KEYDOWN) {
+				keys |= 1 << key;
+			} else {
+				keys &= ~(1 << key);
+			}
+		}
+	}
+	atomic_store(&sh->keys, keys);
+	if (commands & ~CMD_TURBO) {
+		atomic_fetch_or(&sh->commands, commands & ~CMD_TURBO);
+	}
+	/* Toggles cancel out until the emulation thread takes them */
+	if (commands & CMD_TURBO) {
+		atomic_fetch_xor(&sh->commands, CMD_TURBO);
+	}
+}
+
+/*
+ * Carry out on the emulation thread the commands of the render thread, then
+ * latch which emulator keys are held down into in.
+ *
+ * Without subframe, the latched keys are applied to machine c at once. With
+ * subframe, the changes the event filter recorded are taken into in to be
+ * applied while the next instructions run.
+ */
+static void _take_input(shared* sh, input* in, unsigned commands,
+	u_int8_t* turbo, scheduler* s)
+{
+	chip8* c = sh->c;
+	unsigned tail;
+	int key;
+
+	if (commands & CMD_TRACE) {
+		dump_trace(c, stdout);
+	}
+	if (commands & CMD_SAVE) {
+		save_machine(c, &_slot);
+		_saved = 1;
+	}
+	if ((commands & CMD_RESTORE) && _saved) {
+		restore_machine(c, &_slot);
+	}
+	if (commands & CMD_TURBO) {
+		*turbo = !*turbo;
+		resync(s);
+	}
+	if (!sh->config->subframe) {
+		in->mask = atomic_load(&sh->keys);
+		set_key_mask(c, in->mask);
+		return;
+	}
+
+	/* Apply whatever was left over, then take the newly recorded changes */
+	while (in->next < in->count) {
+		key = in->pending[in->next].key;
+		in->mask = (in->mask & ~(1 << key)) | in->pending[in->next].down << key;
+		in->next++;
+	}
+	set_key_mask(c, in->mask);
+	in->count = 0;
+	in->next = 0;
+	in->from = in->to;
+	in->to = monotonic_ns();
+	tail = atomic_load(&_transitions.tail);
+	while (tail != atomic_load(&_transitions.head)) {
+		in->pending[in->count++] = _transitions.ring[tail % MAX_TRANSITIONS];
+		tail++;
+	}
+	atomic_store(&_transitions.tail, tail);
+}
+
+/*
+ * Apply to machine c every pending change of in which is due once done out of
+ * total instructions have been executed. A change is due after the share of
+ * the instructions equal to the share of the interval it was recorded in.
+ */
+static void _apply_due(chip8* c, input* in, u_int32_t done, u_int32_t total)
+{
+	key_transition* t;
+	u_int64_t span = in->to - in->from;
+
+	while (in->next < in->count) {
+		t = &in->pending[in->next];
+		if (span && t->time > in->from
+			&& (t->time - in->from) * total > (u_int64_t) done * span) {
+			return;
+		}
+		c->keys[t->key] = t->down;
+		c->idle = 0;
+		in->mask = (in->mask & ~(1 << t->key)) | t->down << t->key;
+		in->next++;
+	}
+}
+
+void refresh_screen(const frame* f, u_int64_t dirty)
+{
+	int y, top;
+	int n = 0;
+	int height = f->hires ? HIRES_HEIGHT : HEIGHT;
+	int scale = f->hires ? HIRES_SCALE : SCALE;
+	SDL_Rect rects[HIRES_HEIGHT];
+	SDL_Surface* emulator_screen = SDL_GetVideoSurface();
+
+	if (!dirty) {
+		return;
+	}
+
+	/* Secure surface to access pixels */
+	SDL_LockSurface(emulator_screen);
+
+	/* Redraw the rows of the emulator screen which DRW or CLS changed */
+	if (f->hires) {
+		expand_hires_rows(f->hires_screen, dirty,
+			(Uint32*) emulator_screen->pixels,
+			emulator_screen->pitch / sizeof(Uint32));
+	} else {
+		expand_rows(f->screen, dirty, (Uint32*) emulator_screen->pixels,
+			emulator_screen->pitch / sizeof(Uint32));
+	}
+
+	/* Release surface */
+	SDL_UnlockSurface(emulator_screen);
+
+	/* A double buffered screen is flipped whole, waiting for vertical sync */
+	if (emulator_screen->flags & SDL_DOUBLEBUF) {
+		SDL_Flip(emulator_screen);
+		return;
+	}
+
+	/* Update one rectangle for each run of changed rows */
+	for (y = 0; y < height; y++) {
+		if (!(dirty & (1ULL << y))) {
+			continue;
+		}
+		for (top = y; y + 1 < height && (dirty & (1ULL << (y + 1))); y++);
+		rects[n].x = 0;
+		rects[n].y = top * scale;
+		rects[n].w = EMU_W;
+		rects[n].h = (y - top + 1) * scale;
+		n++;
+	}
+	SDL_UpdateRects(emulator_screen, n, rects);
+}
+
+/*
+ * Run ticks ticks of schedule s on machine c: for each, execute the
+ * instructions it holds, then decrement the timers. Pending key changes of in
+ * are applied as their time comes. If the machine halts, the reason is printed,
+ * and the trace unless the program exited, and -1 is returned; 0 otherwise.
+ */
+static int _run_ticks(chip8* c, scheduler* s, u_int32_t ticks, input* in)
+{
+	u_int32_t n[MAX_CATCHUP];
+	u_int32_t total = 0;
+	u_int32_t done = 0;
+	u_int32_t i, k, chunk;
+	u_int64_t due;
+
+	for (k = 0; k < ticks; k++) {
+		n[k] = tick_cycles(s);
+		total += n[k];
+	}
+	for (k = 0; k < ticks; k++) {
+		for (i = 0; i < n[k]; i += chunk) {
+			_apply_due(c, in, done, total);
+			/* Run up to the next pending change in one go */
+			chunk = n[k] - i;
+			if (in->next < in->count && in->to > in->from) {
+				due = (in->pending[in->next].time - in->from) * total
+					/ (in->to - in->from) + 1;
+				if (due > done && due - done < chunk) {
+					chunk = due - done;
+				}
+			}
+			/* Instructions an idle machine skips still count as done */
+			run_cycles(c, chunk);
+			done += chunk;
+			if (c->halt) {
+				print_halt(c);
+				if (c->halt != HALT_EXIT) {
+					dump_trace(c, stderr);
+				}
+				return -1;
+			}
+		}
+		_decrement_timers(c);
+		set_buzzer(c->sound_timer > 0);
+	}
+	return 0;
+}
+
+/*
+ * Emulation thread: run the machine of sh on the schedule of its config,
+ * publishing its screen whenever something was drawn, until told to quit or
+ * the machine halts.
+ */
+static void* _emulate(void* arg)
+{
+	shared* sh = arg;
+	chip8* c = sh->c;
+	const frontend_config* config = sh->config;
+	u_int64_t present;
+	u_int32_t ticks;
+	u_int8_t turbo = config->turbo;
+	u_int8_t rewinding;
+	unsigned commands;
+	int status = EXIT_SUCCESS;
+	scheduler s;
+	input in;
+	rewinder* r = alloc_rewind();
+
+	init_scheduler(&s, config->ips);
+	if (config->speed > 0) {
+		set_speed(&s, config->speed);
+	}
+	memset(&in, 0, sizeof(in));
+	in.to = monotonic_ns();
+	if (!r) {
+		printf("Not enough memory to rewind\n");
+	}
+
+	for (;;) {
+		commands = atomic_exchange(&sh->commands, 0);
+		if (commands & CMD_QUIT) {
+			break;
+		}
+		_take_input(sh, &in, commands, &turbo, &s);
+		rewinding = r && atomic_load(&sh->rewinding);
+		if (rewinding) {
+			/* Step back one frame for every tick due, at the pace of time */
+			set_buzzer(0);
+			for (ticks = due_ticks(&s); ticks; ticks--) {
+				rewind_frame(r, c);
+			}
+		} else {
+			if (r) {
+				record_frame(r, c);
+			}
+			if (turbo) {
+				/* Run ticks back to back until a frame of real time passed */
+				present = monotonic_ns() + NS_PER_SEC / FRAME_RATE;
+				_apply_due(c, &in, 0, 0);
+				do {
+					if (_run_ticks(c, &s, 1, &in)) {
+						status = EXIT_FAILURE;
+					}
+				} while (!status && monotonic_ns() < present);
+			} else if (_run_ticks(c, &s, due_ticks(&s), &in)) {
+				/* Run every tick which is due by now */
+				status = EXIT_FAILURE;
+			}
+		}
+
+		/* Hand whatever was drawn since the last frame to the render thread */
+		if (c->draw) {
+			c->draw = 0;
+			publish_frame(&sh->frames, c);
+			c->dirty = 0;
+		}
+		if (status) {
+			break;
+		}
+		if (!turbo || rewinding) {
+			wait_tick(&s);
+		}
+	}
+	/* A program which exited itself ran fine */
+	if (c->halt == HALT_EXIT) {
+		status = EXIT_SUCCESS;
+	}
+	free(r);
+	set_buzzer(0);
+	atomic_store(&sh->status, status + 1);
+	return NULL;
+}
+
+void run(chip8* c, const frontend_config* config)
+{
+	const frame* shown = NULL;
+	const frame* f;
+	pthread_t emulation;
+	shared sh;
+	int status;
+
+	/*
+	 * Initialize emulator screen. Key changes are timestamped best from SDL's
+	 * own event thread, where the platform has one
+	 */
+	if (!config->subframe
+		|| SDL_Init(SDL_INIT_EVERYTHING | SDL_INIT_EVENTTHREAD) < 0) {
+		SDL_Init(SDL_INIT_EVERYTHING);
+	}
+	sh.opengl = 0;
+#ifdef OPENGL
+	/* Without OpenGL, the screen is scaled on the CPU as usual */
+	sh.opengl = config->opengl && !open_gl_display(config->vsync);
+#endif
+	if (sh.opengl) {
+		/* The window is already open */
+	} else if (config->vsync) {
+		SDL_SetVideoMode(EMU_W, EMU_H, BPP, SDL_HWSURFACE | SDL_DOUBLEBUF);
+	} else {
+		SDL_SetVideoMode(EMU_W, EMU_H, BPP, SDL_SWSURFACE);
+	}
+	if (config->subframe) {
+		SDL_SetEventFilter(_filter);
+	}
+	open_audio();
+
+	sh.c = c;
+	sh.config = config;
+	init_frames(&sh.frames);
+	atomic_init(&sh.keys, 0);
+	atomic_init(&sh.commands, 0);
+	atomic_init(&sh.rewinding, 0);
+	atomic_init(&sh.status, 0);
+	if (pthread_create(&emulation, NULL, _emulate, &sh)) {
+		printf("Could not start the emulation thread\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* Render thread: present the newest frame and pass input on */
+	while (!(status = atomic_load(&sh.status))) {
+		_poll_events(&sh);
+		f = take_frame(&sh.frames);
+		if (sh.opengl) {
+#ifdef OPENGL
+			/* The texture keeps the screen, so only changed rows go up */
+			if (f || config->vsync) {
+				present_gl(f, f ? f->dirty : 0);
+			}
+#endif
+		} else if (config->vsync) {
+			/* Both buffers must be redrawn, and flipping paces the frame */
+			shown = f ? f : shown;
+			if (shown) {
+				refresh_screen(shown, ALL_ROWS);
+			}
+		} else if (f) {
+			refresh_screen(f, f->dirty);
+		}
+		SDL_Delay(1);
+	}
+	pthread_join(emulation, NULL);
+	close_audio();
+	exit(status - 1);
+}
+#endif
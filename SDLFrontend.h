@@ -0,0 +1,126 @@
+/*
+ * SDL front end for the CHIP-8 emulator.
+ *
+ * Displays the screen of a machine in an SDL window and feeds it input from
+ * the keyboard. Everything that depends on SDL lives behind this header so that
+ * the emulator core can be built and run without it; define NO_SDL to leave
+ * this front end out of the build entirely.
+ *
+ * INFO:
+ * https://www.libsdl.org/release/SDL-1.2.15/docs/
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef SDLFRONTEND_H_
+#define SDLFRONTEND_H_
+
+/* INCLUDE */
+#include "CHIP8Emulator.h"
+#include "TripleBuffer.h"
+
+/* Emulator keys. A normal CHIP-8 keyboard would be in the following order:
+ *     1 2 3 C
+ *     4 5 6 D
+ *     7 8 9 E
+ *     A 0 B F
+ *
+ * This emulator has these keys arranged in the following order:
+ *     1 2 3 4
+ *     Q W E R
+ *     A S D F
+ *     Z X C V
+ */
+extern u_int8_t emulator_keys[NUM_KEYS];
+
+/* How the front end runs the machine and presents the screen */
+typedef struct frontend_config {
+	u_int32_t ips;  // instructions per second, 0 for DEFAULT_IPS
+	double speed;   // speed multiplier, 0 for real time
+	u_int8_t turbo; // start in turbo mode
+	u_int8_t vsync; // flip a double buffered screen on vertical sync
+	u_int8_t subframe; // apply key changes at the time they happened
+	u_int8_t opengl;   // present through OpenGL, if built with OPENGL
+} frontend_config;
+
+/* PROTOTYPES */
+/*
+ * Redraw the rows of the emulator screen set in dirty from the screen of
+ * frame f, the CHIP-8 or the hi-res one.
+ *
+ * DRW and CLS mark the rows of the CHIP-8 screen they change as dirty. Only
+ * those rows are expanded onto the emulator screen, and only the rectangles
+ * they cover are updated, so refreshing costs in proportion to how much of the
+ * screen changed. The emulator screen is single buffered so that rows which
+ * didn't change remain as they were.
+ */
+void refresh_screen(const frame* f, u_int64_t dirty);
+
+/*
+ * Runs program in the RAM of machine c.
+ *
+ * While there are instructions without error, the emulator runs whatever CHIP-8
+ * source is located in its RAM. This method will first initiate the emulator
+ * screen, then it will continually perform the fetch, decode, and execute cycle
+ * while there are instructions to execute.
+ *
+ * The machine runs on an emulation thread of its own, so that presenting the
+ * screen never holds up execution and execution never holds up presenting.
+ * The emulation thread publishes the screen through a triple buffer (see
+ * TripleBuffer.h) whenever something was drawn; the calling thread, which
+ * owns the window, presents the newest published screen and polls for
+ * events, passing the keys held down back as an atomic key mask and the keys
+ * of the front end itself as commands.
+ *
+ * This method will also update the CHIP-8 keyboard values using the emulator
+ * keys. Once per frame, the emulation thread takes the key mask: for every key
+ * on the emulator keyboard that is pressed, the corresponding CHIP-8 key in
+ * the keys pointer will also be marked as pressed, and any non-pressed
+ * emulator key will be marked as not pressed. The keys then stay latched
+ * while the frame's instructions run. With subframe set in config, each key
+ * change is instead timestamped when SDL receives it and applied part way
+ * through the next frame's instructions, at the same share of the frame it
+ * happened in, so that short presses and the order of presses are kept.
+ * Escape ends the emulator.
+ *
+ * Execution follows the wall clock through a scheduler (see Scheduler.h): the
+ * delay and sound timers are decremented FRAME_RATE times per second, and
+ * between two decrements the number of instructions which config's ips rate
+ * calls for are executed. DRW only marks the screen as changed, and the screen
+ * is published at most once per frame, after all due instructions ran; the
+ * emulation thread then sleeps until the next tick is due. With vsync set in
+ * config, the screen is double buffered and the newest screen redrawn on
+ * every vertical sync; otherwise each screen is presented as soon as it is
+ * published.
+ *
+ * The speed multiplier in config runs the schedule faster or slower than real
+ * time. Pressing Tab, or setting turbo in config, switches to turbo mode where
+ * ticks are run back to back as fast as the host allows, still with the same
+ * number of instructions each, and the screen is only presented FRAME_RATE
+ * times per second of real time. Pressing Tab again returns to the schedule.
+ *
+ * The buzzer sounds while the sound timer is greater than 0 (see Audio.h):
+ * after every tick, the emulation thread sets its state for the audio
+ * callback to play. Without audio, the emulator runs silently.
+ *
+ * With opengl set in config, and the emulator built with OPENGL, the screen is
+ * presented through OpenGL instead (see GLDisplay.h): only the native screen
+ * is uploaded, the GPU scales it, and the window can be resized to any size.
+ * If OpenGL isn't available, the screen is presented as without it.
+ *
+ * If the machine halts, the reason and the trace are printed and the emulator
+ * ends; both threads stop before it does. If the program exited, there is no
+ * trace. Pressing F1 prints the trace at any
+ * time. Pressing F5 saves the machine to a quick save slot in memory and F9
+ * restores it (see SaveState.h).
+ *
+ * The state of the machine is recorded into a rewind buffer every frame (see
+ * Rewind.h). While Backspace is held down, the machine runs backwards through
+ * the recorded frames instead, one frame per tick.
+ */
+void run(chip8* c, const frontend_config* config);
+
+#endif
@@ -0,0 +1,121 @@
+#include <string.h>
+#include "BlockEngine.h"
+#include "CHIP8Emulator.h"
+#include "SaveState.h"
+
+static int _valid(const state_header* h)
+{
+	return h->magic == STATE_MAGIC && h->version == STATE_VERSION
+		&& h->size == STATE_SIZE;
+}
+
+void save_machine(const chip8* c, save_state* s)
+{
+	s->header.magic = STATE_MAGIC;
+	s->header.version = STATE_VERSION;
+	s->header.size = STATE_SIZE;
+	memcpy(s->data, c, STATE_SIZE);
+}
+
+int restore_machine(chip8* c, const save_state* s)
+{
+	if (!_valid(&s->header)) {
+		return -1;
+	}
+	memcpy(c, s->data, STATE_SIZE);
+
+	/* Everything may have changed since the state was taken */
+	c->dirty = ALL_ROWS;
+	c->draw = 1;
+	c->touched = ~0ULL;
+	flush_cache(c);
+	return 0;
+}
+
+void reset_machine(chip8* c, const save_state* image)
+{
+	const u_int8_t* ram = image->data + offsetof(chip8, RAM);
+	u_int64_t pages = c->touched;
+	address a;
+	address b;
+
+	/* Everything but RAM is small enough to copy back whole */
+	memcpy(c, image->data, offsetof(chip8, RAM));
+	memcpy(c->screen, image->data + offsetof(chip8, screen),
+		STATE_SIZE - offsetof(chip8, screen));
+
+	for (; pages; pages &= pages - 1) {
+		a = __builtin_ctzll(pages) * SIZE_PAGE;
+		if (!memcmp(c->RAM + a, ram + a, SIZE_PAGE)) {
+			continue;
+		}
+		memcpy(c->RAM + a, ram + a, SIZE_PAGE);
+
+		/* Discard what was decoded from the page, as write_mem would */
+		for (b = a; b < a + SIZE_PAGE; b++) {
+			if (c->cache) {
+				c->cache[b].op = OP_NONE;
+				c->cache[MEM(b - 1)].op = OP_NONE;
+			}
+			if (c->blocks) {
+				invalidate_blocks(c, b);
+			}
+		}
+	}
+
+	c->dirty = ALL_ROWS;
+	c->draw = 1;
+	c->touched = 0;
+}
+
+int write_state(const save_state* s, FILE* f)
+{
+	return fwrite(s, sizeof(save_state), 1, f) == 1 ? 0 : -1;
+}
+
+int read_state(save_state* s, FILE* f)
+{
+	if (fread(&s->header, sizeof(state_header), 1, f) != 1
+		|| !_valid(&s->header)) {
+		return -1;
+	}
+	return fread(s->data, STATE_SIZE, 1, f) == 1 ? 0 : -1;
+}
+
+int save_file(const chip8* c, const char* path)
+{
+	save_state s;
+	FILE* f = fopen(path, "wb");
+	int error;
+
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+	save_machine(c, &s);
+	error = write_state(&s, f);
+	if (fclose(f) || error) {
+		printf("Could not write state to %s\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+int restore_file(chip8* c, const char* path)
+{
+	save_state s;
+	FILE* f = fopen(path, "rb");
+	int error;
+
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+	error = read_state(&s, f);
+	fclose(f);
+	if (error || restore_machine(c, &s)) {
+		printf("%s is not a state saved by this emulator\n", path);
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * Save states for the CHIP-8 emulator.
+ *
+ * The architectural state of a machine (registers, timers, keys, RAM, screen
+ * and random number generator) is laid out at the start of the chip8
+ * structure, up to its engine field. A save state is a short header followed
+ * by a bulk copy of that block, so taking or restoring one costs a few
+ * kilobytes of memcpy. The header records a magic number, the format version
+ * and the size of the block; a state whose header does not match this build
+ * is refused. States are stored in the byte order of the host which took them.
+ *
+ * Execution engine caches are not part of the state; restoring a state
+ * flushes them since the RAM they were built from has changed.
+ *
+ * A state taken right after a ROM is loaded also serves as a pristine image
+ * to reset the machine to. Resetting copies the registers and screen back
+ * whole but only those pages of RAM which were written since, so that it
+ * costs in proportion to how much memory the last run touched.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef SAVESTATE_H_
+#define SAVESTATE_H_
+
+/* INCLUDE */
+#include <stddef.h>
+#include <stdio.h>
+#include "InstructionSet.h"
+
+/* DEFINE */
+#define STATE_MAGIC 0x53533843 // "C8SS" read as a little-endian word
+#define STATE_VERSION 3
+/* Size of the contiguous block of a chip8 holding its state */
+#define STATE_SIZE offsetof(chip8, engine)
+
+/* TYPEDEFS */
+typedef struct state_header {
+	u_int32_t magic;   // STATE_MAGIC
+	u_int16_t version; // STATE_VERSION of the build which saved the state
+	u_int16_t size;    // STATE_SIZE of the build which saved the state
+} state_header;
+
+typedef struct save_state {
+	state_header header;
+	u_int8_t data[STATE_SIZE];
+} save_state;
+
+/* PROTOTYPES */
+/*
+ * Copy the state of machine c into s.
+ */
+void save_machine(const chip8* c, save_state* s);
+
+/*
+ * Replace the state of machine c with s.
+ *
+ * The whole screen is marked as changed, the caches of the execution engine
+ * are flushed, and every page of memory is marked as touched. Returns 0 on
+ * success, or -1 without changing c if s was not saved by a build with the
+ * same state format.
+ */
+int restore_machine(chip8* c, const save_state* s);
+
+/*
+ * Reset machine c to image, a state taken from c while none of its memory was
+ * marked as touched, such as right after initialize and load_source.
+ *
+ * Only the pages of RAM marked as touched are copied back, and only the
+ * instructions predecoded or translated from those pages are discarded. The
+ * whole screen is marked as changed and no page is marked as touched anymore.
+ */
+void reset_machine(chip8* c, const save_state* image);
+
+/*
+ * Write s to f. Returns 0 on success, -1 on error.
+ */
+int write_state(const save_state* s, FILE* f);
+
+/*
+ * Read a state from f into s. Returns 0 on success, or -1 if the state could
+ * not be read or was not saved by a build with the same state format.
+ */
+int read_state(save_state* s, FILE* f);
+
+/*
+ * Write the state of machine c to the file at path. Returns 0 on success, or
+ * -1 after printing the error.
+ */
+int save_file(const chip8* c, const char* path);
+
+/*
+ * Restore machine c from the state in the file at path. Returns 0 on success,
+ * or -1 after printing the error.
+ */
+int restore_file(chip8* c, const char* path);
+
+#endif
@@ -0,0 +1,69 @@
+#include <errno.h>
+#include <time.h>
+#include "Scheduler.h"
+
+void init_scheduler(scheduler* s, u_int32_t ips)
+{
+	s->ips = ips ? ips : DEFAULT_IPS;
+	s->remainder = 0;
+	s->period = NS_PER_SEC / FRAME_RATE;
+	s->next_tick = monotonic_ns();
+}
+
+void set_speed(scheduler* s, double speed)
+{
+	s->period = NS_PER_SEC / (FRAME_RATE * speed);
+	resync(s);
+}
+
+void resync(scheduler* s)
+{
+	s->next_tick = monotonic_ns();
+}
+
+u_int64_t monotonic_ns()
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (u_int64_t) t.tv_sec * NS_PER_SEC + t.tv_nsec;
+}
+
+u_int32_t due_ticks(scheduler* s)
+{
+	u_int64_t now = monotonic_ns();
+	u_int64_t due;
+
+	if (now < s->next_tick) {
+		return 0;
+	}
+	due = (now - s->next_tick) / s->period + 1;
+	if (due > MAX_CATCHUP) {
+		/* Drop the ticks which can't be caught up on */
+		s->next_tick = now + s->period;
+		return MAX_CATCHUP;
+	}
+	s->next_tick += due * s->period;
+	return due;
+}
+
+u_int32_t tick_cycles(scheduler* s)
+{
+	u_int32_t n = s->ips / FRAME_RATE;
+
+	s->remainder += s->ips % FRAME_RATE;
+	if (s->remainder >= FRAME_RATE) {
+		s->remainder -= FRAME_RATE;
+		n++;
+	}
+	return n;
+}
+
+void wait_tick(const scheduler* s)
+{
+	struct timespec t;
+
+	t.tv_sec = s->next_tick / NS_PER_SEC;
+	t.tv_nsec = s->next_tick % NS_PER_SEC;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR);
+}
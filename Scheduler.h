@@ -0,0 +1,84 @@
+/*
+ * Scheduling of CHIP-8 execution against the wall clock.
+ *
+ * The delay and sound timers of the CHIP-8 count down at 60 Hz, and ROMs rely
+ * on this to run at the right speed. The scheduler ticks the timers at exactly
+ * FRAME_RATE ticks per second of a monotonic clock and, between two ticks, lets
+ * the machine run the number of instructions a configurable instructions per
+ * second rate calls for. When the host falls behind, due ticks are caught up
+ * on, up to MAX_CATCHUP of them; when it is ahead, it sleeps until the exact
+ * time the next tick is due.
+ *
+ * A speed multiplier scales the rate of ticks, and the instructions between
+ * them, without changing how many instructions each tick holds, so a ROM runs
+ * faster or slower but behaves the same.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+/* INCLUDE */
+#include "CHIP8Emulator.h"
+
+#define DEFAULT_IPS (CYCLES_PER_FRAME * FRAME_RATE) // instructions per second
+#define MAX_CATCHUP 5 // ticks caught up on at once before giving up on them
+#define NS_PER_SEC  1000000000ULL
+
+/* Schedule of timer ticks and instructions */
+typedef struct scheduler {
+	u_int32_t ips;       // instructions to execute per second
+	u_int32_t remainder; // instructions per second owed to the next ticks
+	u_int64_t period;    // nanoseconds between two ticks
+	u_int64_t next_tick; // monotonic time at which the next tick is due
+} scheduler;
+
+/* PROTOTYPES */
+/*
+ * Start a schedule executing ips instructions per second, with its first tick
+ * due now. If ips is 0, DEFAULT_IPS is used.
+ */
+void init_scheduler(scheduler* s, u_int32_t ips);
+
+/*
+ * Run the schedule speed times faster than real time, keeping ticks due from
+ * now on. speed must be greater than 0.
+ */
+void set_speed(scheduler* s, double speed);
+
+/*
+ * Forget any ticks which are due and restart the schedule with a tick due now.
+ */
+void resync(scheduler* s);
+
+/*
+ * Return the current time of the monotonic clock in nanoseconds.
+ */
+u_int64_t monotonic_ns();
+
+/*
+ * Return how many ticks are due by now and move the schedule past them.
+ *
+ * If more than MAX_CATCHUP ticks are due, the host has fallen too far behind
+ * to catch up; only MAX_CATCHUP are returned and the rest are dropped.
+ */
+u_int32_t due_ticks(scheduler* s);
+
+/*
+ * Return how many instructions to execute before the next tick.
+ *
+ * When ips is not a multiple of FRAME_RATE, the remainder is spread over the
+ * ticks so that exactly ips instructions are executed every second.
+ */
+u_int32_t tick_cycles(scheduler* s);
+
+/*
+ * Sleep until the next tick is due.
+ */
+void wait_tick(const scheduler* s);
+
+#endif
@@ -0,0 +1,474 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "Stream.h"
+#include "Scheduler.h"
+#include "Trace.h"
+
+/* Screen as streamed: the rows a machine shows, in order, one after the other */
+typedef struct picture {
+	u_int64_t rows[HIRES_HEIGHT * HIRES_WORDS]; // as laid out for encode_frame
+	u_int8_t hires;                             // rows are of the hi-res screen
+} picture;
+
+/* One viewer connected to the server */
+typedef struct viewer {
+	int fd;                      // socket, -1 if the slot is free
+	picture screen;              // screen as the viewer has it once out is sent
+	u_int16_t keys;              // keys the viewer holds down
+	size_t length;               // bytes queued in out
+	u_int8_t out[STREAM_BUFFER]; // messages queued and not sent yet
+} viewer;
+
+/*
+ * Write n to p as 32 bits little endian.
+ */
+static void _put32(u_int8_t* p, u_int32_t n)
+{
+	p[0] = n;
+	p[1] = n >> 8;
+	p[2] = n >> 16;
+	p[3] = n >> 24;
+}
+
+/*
+ * Return the 32 bits little endian at p.
+ */
+static u_int32_t _get32(const u_int8_t* p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (u_int32_t) p[3] << 24;
+}
+
+size_t encode_frame(const u_int64_t* from, const u_int64_t* to, int width,
+	int height, u_int32_t tick, u_int8_t* out)
+{
+	u_int8_t delta[STREAM_MAX_DATA];
+	u_int64_t rows = 0;
+	u_int64_t x;
+	int words = width / 64;
+	size_t n = 0;
+	size_t i, run;
+	u_int8_t* p = out + STREAM_HEADER;
+	int y, w, b, changed;
+
+	/* XOR every row which changed, most significant byte first */
+	for (y = 0; y < height; y++) {
+		for (changed = 0, w = 0; w < words; w++) {
+			changed |= from[y * words + w] != to[y * words + w];
+		}
+		if (!changed) {
+			continue;
+		}
+		rows |= 1ULL << y;
+		for (w = 0; w < words; w++) {
+			x = from[y * words + w] ^ to[y * words + w];
+			for (b = 7; b >= 0; b--) {
+				delta[n++] = x >> (b * 8);
+			}
+		}
+	}
+	if (!rows) {
+		return 0;
+	}
+
+	/*
+	 * Runs of zero bytes take one byte; everything else is copied, broken up
+	 * only by runs of at least two zero bytes, where a run saves a byte
+	 */
+	for (i = 0; i < n; i += run) {
+		if (!delta[i]) {
+			for (run = 1; run < STREAM_MAX_RUN && i + run < n
+				&& !delta[i + run]; run++);
+			*p++ = STREAM_RUN | (run - 1);
+			continue;
+		}
+		for (run = 1; run < STREAM_MAX_RUN && i + run < n
+			&& (delta[i + run] || (i + run + 1 < n && delta[i + run + 1]));
+			run++);
+		*p++ = run - 1;
+		memcpy(p, delta + i, run);
+		p += run;
+	}
+	out[0] = STREAM_FRAME;
+	_put32(out + 1, tick);
+	_put32(out + 5, rows);
+	_put32(out + 9, rows >> 32);
+	return p - out;
+}
+
+long apply_frame(u_int64_t* screen, int width, int height,
+	const u_int8_t* message, size_t length)
+{
+	u_int8_t delta[STREAM_MAX_DATA];
+	u_int64_t rows;
+	int words = width / 64;
+	size_t n = 0;
+	size_t total = 0;
+	size_t i = STREAM_HEADER;
+	size_t run;
+	int y, w, b;
+
+	if (length && message[0] != STREAM_FRAME) {
+		return -1;
+	}
+	if (length < STREAM_HEADER) {
+		return 0;
+	}
+	rows = _get32(message + 5) | (u_int64_t) _get32(message + 9) << 32;
+	if (height < 64 && rows >> height) {
+		return -1;
+	}
+	for (y = 0; y < height; y++) {
+		total += (rows >> y & 1) * words * 8;
+	}
+
+	/* Decode every run before changing anything */
+	while (n < total) {
+		if (i == length) {
+			return 0;
+		}
+		run = (message[i] & ~STREAM_RUN) + 1;
+		if (n + run > total) {
+			return -1;
+		}
+		if (message[i++] & STREAM_RUN) {
+			memset(delta + n, 0, run);
+		} else if (i + run > length) {
+			return 0;
+		} else {
+			memcpy(delta + n, message + i, run);
+			i += run;
+		}
+		n += run;
+	}
+
+	n = 0;
+	for (y = 0; y < height; y++) {
+		if (!(rows & (1ULL << y))) {
+			continue;
+		}
+		for (w = 0; w < words; w++) {
+			for (b = 7; b >= 0; b--) {
+				screen[y * words + w] ^= (u_int64_t) delta[n++] << (b * 8);
+			}
+		}
+	}
+	return i;
+}
+
+/*
+ * Copy to p the screen machine c shows, rows in order.
+ */
+static void _take(const chip8* c, picture* p)
+{
+	int y;
+
+	p->hires = c->hires;
+	if (!c->hires) {
+		memcpy(p->rows, c->screen, sizeof(c->screen));
+		return;
+	}
+	for (y = 0; y < HIRES_HEIGHT; y++) {
+		memcpy(p->rows + y * HIRES_WORDS, HIRES_ROW(c, y),
+			sizeof(c->hires_screen[0]));
+	}
+}
+
+/*
+ * Return whether pictures a and b are the same screen.
+ */
+static int _same(const picture* a, const picture* b)
+{
+	return a->hires == b->hires && !memcmp(a->rows, b->rows,
+		(a->hires ? HIRES_HEIGHT * HIRES_WORDS : HEIGHT) * sizeof(u_int64_t));
+}
+
+/*
+ * Open a non-blocking socket listening on every address at port. Returns it,
+ * or -1 if it can't be set up.
+ */
+static int _listen(u_int16_t port)
+{
+	struct sockaddr_in address;
+	int one = 1;
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	if (fd < 0) {
+		perror("socket");
+		return -1;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port);
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if (bind(fd, (struct sockaddr*) &address, sizeof(address))
+		|| listen(fd, SOMAXCONN)) {
+		perror("bind");
+		close(fd);
+		return -1;
+	}
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+	return fd;
+}
+
+/*
+ * Close the connection of viewer v and free its slot.
+ */
+static void _drop(viewer* v)
+{
+	close(v->fd);
+	v->fd = -1;
+	v->length = 0;
+	v->keys = 0;
+}
+
+/*
+ * Send as much as the socket of v takes of the messages queued for it. Drops
+ * v if its connection failed.
+ */
+static void _flush(viewer* v)
+{
+	ssize_t sent;
+
+	if (!v->length) {
+		return;
+	}
+	sent = send(v->fd, v->out, v->length, MSG_NOSIGNAL | MSG_DONTWAIT);
+	if (sent < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+			_drop(v);
+		}
+		return;
+	}
+	v->length -= sent;
+	memmove(v->out, v->out + sent, v->length);
+}
+
+/*
+ * Accept every viewer waiting to connect to listener into a free slot of
+ * viewers, queueing the hello message for it. Viewers beyond MAX_VIEWERS are
+ * turned away.
+ */
+static void _accept(int listener, viewer* viewers)
+{
+	int fd, i;
+	int one = 1;
+
+	while ((fd = accept(listener, NULL, NULL)) >= 0) {
+		for (i = 0; i < MAX_VIEWERS && viewers[i].fd >= 0; i++);
+		if (i == MAX_VIEWERS) {
+			close(fd);
+			continue;
+		}
+		fcntl(fd, F_SETFL, O_NONBLOCK);
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		viewers[i].fd = fd;
+		memset(&viewers[i].screen, 0, sizeof(viewers[i].screen));
+		viewers[i].out[0] = STREAM_HELLO;
+		viewers[i].out[1] = STREAM_VERSION;
+		viewers[i].out[2] = WIDTH;
+		viewers[i].out[3] = HEIGHT;
+		viewers[i].length = 4;
+	}
+}
+
+/*
+ * Read the key changes viewer v sent. Drops v if it disconnected.
+ */
+static void _receive(viewer* v)
+{
+	u_int8_t in[64];
+	ssize_t n, i;
+
+	while ((n = recv(v->fd, in, sizeof(in), MSG_DONTWAIT)) > 0) {
+		for (i = 0; i < n; i++) {
+			if (in[i] & ~(STREAM_KEY_DOWN | 0xF)) {
+				continue;
+			}
+			if (in[i] & STREAM_KEY_DOWN) {
+				v->keys |= 1 << (in[i] & 0xF);
+			} else {
+				v->keys &= ~(1 << (in[i] & 0xF));
+			}
+		}
+	}
+	if (!n || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+		_drop(v);
+	}
+}
+
+/*
+ * Queue for viewer v whatever it misses of screen, a frame taken at tick
+ * tick, if there is room. message, length bytes long, is the frame message
+ * from shown, the screen before, to screen; it is queued as it is for a
+ * viewer which has shown.
+ */
+static void _update(viewer* v, const picture* screen, const picture* shown,
+	const u_int8_t* message, size_t length, u_int32_t tick)
+{
+	if (v->length + 3 + STREAM_MAX_FRAME > STREAM_BUFFER) {
+		return;
+	}
+	if (v->screen.hires != screen->hires) {
+		v->out[v->length++] = STREAM_RESIZE;
+		v->out[v->length++] = screen->hires ? HIRES_WIDTH : WIDTH;
+		v->out[v->length++] = screen->hires ? HIRES_HEIGHT : HEIGHT;
+		memset(&v->screen, 0, sizeof(v->screen));
+		v->screen.hires = screen->hires;
+	}
+	if (length && _same(&v->screen, shown)) {
+		memcpy(v->out + v->length, message, length);
+		v->length += length;
+	} else if (screen->hires) {
+		v->length += encode_frame(v->screen.rows, screen->rows, HIRES_WIDTH,
+			HIRES_HEIGHT, tick, v->out + v->length);
+	} else {
+		v->length += encode_frame(v->screen.rows, screen->rows, WIDTH, HEIGHT,
+			tick, v->out + v->length);
+	}
+	v->screen = *screen;
+}
+
+/*
+ * Tell every viewer machine c halted, send what is queued as far as the
+ * sockets take it, and close every connection.
+ */
+static void _end(const chip8* c, viewer* viewers)
+{
+	int i;
+
+	for (i = 0; i < MAX_VIEWERS; i++) {
+		if (viewers[i].fd < 0) {
+			continue;
+		}
+		if (viewers[i].length + 2 <= STREAM_BUFFER) {
+			viewers[i].out[viewers[i].length++] = STREAM_END;
+			viewers[i].out[viewers[i].length++] = c->halt;
+		}
+		_flush(&viewers[i]);
+		if (viewers[i].fd >= 0) {
+			_drop(&viewers[i]);
+		}
+	}
+}
+
+int serve_stream(chip8* c, const stream_config* config)
+{
+	struct pollfd fds[MAX_VIEWERS + 1];
+	u_int8_t message[STREAM_MAX_FRAME];
+	picture shown, before;
+	u_int32_t tick = 0;
+	u_int32_t ticks;
+	u_int16_t keys = 0;
+	u_int16_t held;
+	u_int64_t now;
+	size_t length;
+	int timeout, i;
+	scheduler s;
+	viewer* viewers;
+	int listener = _listen(config->port);
+
+	if (listener < 0) {
+		return -1;
+	}
+	if (!(viewers = malloc(MAX_VIEWERS * sizeof(viewer)))) {
+		printf("Not enough memory for the viewers\n");
+		close(listener);
+		return -1;
+	}
+	for (i = 0; i < MAX_VIEWERS; i++) {
+		viewers[i].fd = -1;
+		viewers[i].length = 0;
+		viewers[i].keys = 0;
+	}
+	memset(&shown, 0, sizeof(shown));
+	_take(c, &shown);
+	printf("Streaming on port %u\n", config->port);
+	init_scheduler(&s, config->ips);
+
+	for (;;) {
+		/* Wait for a viewer until the next tick is due */
+		fds[0].fd = listener;
+		fds[0].events = POLLIN;
+		for (i = 0; i < MAX_VIEWERS; i++) {
+			fds[i + 1].fd = viewers[i].fd;
+			fds[i + 1].events = POLLIN | (viewers[i].length ? POLLOUT : 0);
+			fds[i + 1].revents = 0;
+		}
+		now = monotonic_ns();
+		timeout = s.next_tick > now
+			? (s.next_tick - now + 999999) / 1000000 : 0;
+		if (poll(fds, MAX_VIEWERS + 1, timeout) < 0 && errno != EINTR) {
+			perror("poll");
+			break;
+		}
+		if (fds[0].revents & POLLIN) {
+			_accept(listener, viewers);
+		}
+		for (i = 0; i < MAX_VIEWERS; i++) {
+			if (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) {
+				_receive(&viewers[i]);
+			}
+		}
+
+		/* Keys are held down while any viewer holds them */
+		held = 0;
+		for (i = 0; i < MAX_VIEWERS; i++) {
+			held |= viewers[i].keys;
+		}
+		if (held != keys) {
+			keys = held;
+			set_key_mask(c, keys);
+		}
+
+		for (ticks = due_ticks(&s); ticks && !c->halt; ticks--) {
+			run_cycles(c, tick_cycles(&s));
+			if (!c->halt) {
+				_decrement_timers(c);
+				tick++;
+			}
+		}
+		if (c->halt) {
+			break;
+		}
+
+		/* Queue the frame once for every viewer, and send it in one go */
+		length = 0;
+		if (c->draw) {
+			before = shown;
+			_take(c, &shown);
+			if (before.hires == shown.hires) {
+				length = encode_frame(before.rows, shown.rows,
+					shown.hires ? HIRES_WIDTH : WIDTH,
+					shown.hires ? HIRES_HEIGHT : HEIGHT, tick, message);
+			}
+			c->draw = 0;
+			c->dirty = 0;
+		}
+		for (i = 0; i < MAX_VIEWERS; i++) {
+			if (viewers[i].fd >= 0) {
+				_update(&viewers[i], &shown, &before, message, length, tick);
+				_flush(&viewers[i]);
+			}
+		}
+	}
+
+	if (c->halt) {
+		print_halt(c);
+		if (c->halt != HALT_EXIT) {
+			dump_trace(c, stderr);
+		}
+	}
+	_end(c, viewers);
+	free(viewers);
+	close(listener);
+	return c->halt == HALT_EXIT ? 0 : -1;
+}
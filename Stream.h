@@ -0,0 +1,111 @@
+/*
+ * Streaming of a CHIP-8 session to remote viewers over TCP.
+ *
+ * The server runs one machine on the wall clock, as the SDL front end does,
+ * and streams its screen to every viewer connected, taking key presses back
+ * from all of them. Everything runs on one thread around poll(), with every
+ * socket non-blocking, so no viewer can hold up the machine or another viewer.
+ *
+ * Protocol. On connecting, a viewer receives a hello message:
+ *     'H' <version> <width> <height>
+ * one byte each, STREAM_VERSION and the screen size in pixels; the screen is
+ * blank. Whenever the machine switches between the CHIP-8 and the hi-res
+ * screen, the server sends a resize message:
+ *     'R' <width> <height>
+ * after which the screen is blank again, at the new size. The server sends a
+ * frame message whenever the screen differs from what the viewer last
+ * received:
+ *     'F' <tick> <rows> <data>
+ * tick is the number of 60 Hz ticks run when the frame was taken, 32-bit
+ * little endian, and rows a mask of the rows that changed, bit y for row y,
+ * 64-bit little endian. data holds, run length encoded, the XOR of each
+ * changed row with the row as the viewer has it: width / 8 bytes per row, the
+ * leftmost pixel in the most significant bit of the first, rows in increasing
+ * order. Each run starts with a byte n; if bit 7 of n is set, the run is
+ * (n & 0x7F) + 1 zero bytes, otherwise n + 1 bytes follow as they are. The
+ * runs end once they decoded every changed row. If the machine halts, or the
+ * program exits, the server sends
+ *     'E' <reason>
+ * with the HALT_ reason, and closes every connection.
+ *
+ * A viewer sends one byte per key change: the CHIP-8 key in the low 4 bits,
+ * and STREAM_KEY_DOWN set if the key was pressed or clear if released. A key
+ * is held down while any viewer holds it; a viewer disconnecting releases its
+ * keys. Any other byte is ignored.
+ *
+ * A frame message is tiny, at most STREAM_MAX_FRAME bytes and usually a few
+ * dozen, so one host serves many viewers. Messages queue per viewer and are
+ * sent once per turn of the loop, so frames queued together go out in one
+ * packet. A viewer whose queue is too full to take another frame stops
+ * receiving frames; once its queue drains, it receives a single frame
+ * covering every change it missed.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef STREAM_H_
+#define STREAM_H_
+
+/* INCLUDE */
+#include <stddef.h>
+#include "CHIP8Emulator.h"
+
+/* DEFINE */
+#define STREAM_VERSION  2
+#define STREAM_HELLO    'H'  // hello message
+#define STREAM_RESIZE   'R'  // resize message
+#define STREAM_FRAME    'F'  // frame message
+#define STREAM_END      'E'  // end message
+#define STREAM_KEY_DOWN 0x10 // key change byte: the key was pressed
+#define STREAM_RUN      0x80 // run byte: a run of zero bytes
+#define STREAM_MAX_RUN  128  // longest run
+#define STREAM_HEADER   13   // bytes of a frame message before its data
+
+/* Longest frame message: every hi-res row as bytes which aren't zero */
+#define STREAM_MAX_DATA  (HIRES_HEIGHT * HIRES_WIDTH / 8)
+#define STREAM_MAX_FRAME (STREAM_HEADER + STREAM_MAX_DATA \
+	+ (STREAM_MAX_DATA + STREAM_MAX_RUN - 1) / STREAM_MAX_RUN)
+
+#define MAX_VIEWERS   256  // viewers connected at once
+#define STREAM_BUFFER 8192 // bytes queued per viewer
+
+/* TYPEDEFS */
+/* Where and how fast the server runs */
+typedef struct stream_config {
+	u_int16_t port; // TCP port to listen on
+	u_int32_t ips;  // instructions per second, 0 for DEFAULT_IPS
+} stream_config;
+
+/* PROTOTYPES */
+/*
+ * Write to out the frame message taking a viewer from screen from to screen
+ * to, at tick tick. Both screens are height rows of width pixels, a multiple
+ * of 64, each row packed into width / 64 words as in chip8, one after the
+ * other. Returns its length, or 0 if the screens are equal.
+ */
+size_t encode_frame(const u_int64_t* from, const u_int64_t* to, int width,
+	int height, u_int32_t tick, u_int8_t* out);
+
+/*
+ * Apply the frame message at the start of the length bytes of message to
+ * screen, laid out as for encode_frame. Returns the length of the message, 0
+ * if length holds only part of it, or -1 if it isn't a valid frame message.
+ */
+long apply_frame(u_int64_t* screen, int width, int height,
+	const u_int8_t* message, size_t length);
+
+/*
+ * Serve the program in the RAM of machine c to viewers connecting to the port
+ * of config, until the machine halts.
+ *
+ * If the socket can't be set up, an error message is printed and -1 is
+ * returned. When the machine halts, the reason and the trace are printed,
+ * the viewers are told, and -1 is returned as well; if the program exited,
+ * there is no trace and 0 is returned.
+ */
+int serve_stream(chip8* c, const stream_config* config);
+
+#endif
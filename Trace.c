@@ -0,0 +1,20 @@
+#include "Trace.h"
+
+void dump_trace(const chip8* c, FILE* f)
+{
+#ifdef TRACE
+	u_int32_t n = c->trace_next < TRACE_SIZE ? c->trace_next : TRACE_SIZE;
+	u_int32_t j;
+	const trace_entry* e;
+
+	fprintf(f, "Last %u instructions:\n", n);
+	for (j = c->trace_next - n; j != c->trace_next; j++) {
+		e = &c->trace[j & (TRACE_SIZE - 1)];
+		fprintf(f, "0x%04X: 0x%04X  I = 0x%04X  sp = 0x%04X  Vx = 0x%02X"
+			"  Vy = 0x%02X  VF = 0x%02X  DT = %u\n", e->pc, e->i, e->I, e->sp,
+			e->vx, e->vy, e->vf, e->delay_timer);
+	}
+#else
+	fprintf(f, "No trace recorded: compile with TRACE defined\n");
+#endif
+}
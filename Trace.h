@@ -0,0 +1,52 @@
+/*
+ * Instruction tracing for the CHIP-8 emulator.
+ *
+ * When compiled with TRACE defined, every machine records each instruction it
+ * executes into a ring buffer holding the last TRACE_SIZE instructions: the
+ * address and value of the instruction along with I, the stack pointer, Vx,
+ * Vy, VF, and the delay timer as they were just before it ran. Recording only
+ * copies these values; nothing is formatted until the trace is dumped, which
+ * is done when a machine halts or on request.
+ *
+ * Without TRACE defined, recording compiles to nothing and machines hold no
+ * trace at all.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/* INCLUDE */
+#include <stdio.h>
+#include "InstructionSet.h"
+
+#ifdef TRACE
+/* Record the instruction at address a, decoded as d, into the trace of c */
+#define TRACE_RECORD(c, a, d) do { \
+	trace_entry* e_ = &(c)->trace[(c)->trace_next++ & (TRACE_SIZE - 1)]; \
+	e_->pc = (a); \
+	e_->i = INSTR((c)->RAM[MEM(a)], (c)->RAM[MEM((a) + 1)]); \
+	e_->I = (c)->I; \
+	e_->sp = (c)->sp; \
+	e_->vx = (c)->v[(d)->x]; \
+	e_->vy = (c)->v[(d)->y]; \
+	e_->vf = (c)->v[0xF]; \
+	e_->delay_timer = (c)->delay_timer; \
+} while (0)
+#else
+#define TRACE_RECORD(c, a, d)
+#endif
+
+/* PROTOTYPES */
+/*
+ * Print the trace of machine c to f, oldest instruction first.
+ *
+ * Without TRACE defined, prints that no trace was recorded.
+ */
+void dump_trace(const chip8* c, FILE* f);
+
+#endif
@@ -0,0 +1,282 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "BlockEngine.h"
+#include "Quirks.h"
+#include "RomCache.h"
+#include "TranslationCache.h"
+
+#define PATH_SIZE 512 // longest path of a cache file
+#define LAYOUT    (sizeof(block) + sizeof(decoded))
+
+/*
+ * Write the path of the cache file of machine c in dir to path.
+ */
+static void _path(const chip8* c, const char* dir, char* path)
+{
+	snprintf(path, PATH_SIZE, "%s/%016llx-%s.tc", dir,
+		(unsigned long long) hash_rom(c), quirk_profiles[c->quirks]->name);
+}
+
+/*
+ * Return the size of a file holding what header h describes.
+ */
+static size_t _size(const translation_header* h)
+{
+	return sizeof(translation_header)
+		+ __builtin_popcountll(h->pages) * (size_t) SIZE_PAGE
+		+ h->num_blocks * sizeof(block) + h->num_code * sizeof(decoded);
+}
+
+/*
+ * Return whether address a lies in one of pages.
+ */
+static int _in(u_int64_t pages, address a)
+{
+	return (pages >> (MEM(a) / SIZE_PAGE)) & 1;
+}
+
+/*
+ * Return whether the size bytes of a cache file at data may be used for
+ * machine c.
+ */
+static int _valid(const chip8* c, const u_int8_t* data, size_t size)
+{
+	const translation_header* h = (const translation_header*) data;
+	const u_int8_t* page = data + sizeof(translation_header);
+	const block* blocks;
+	const decoded* code;
+	u_int64_t pages;
+	address a;
+	int j;
+	int k;
+
+	if (size < sizeof(translation_header) || h->magic != TRANSLATION_MAGIC
+		|| h->version != TRANSLATION_VERSION || h->quirks != c->quirks
+		|| h->layout != LAYOUT || h->hash != hash_rom(c)
+		|| !h->num_blocks || h->num_blocks > MAX_BLOCKS
+		|| h->num_code > MAX_CODE || size != _size(h)) {
+		return 0;
+	}
+
+	/* Memory must hold exactly what was translated */
+	for (pages = h->pages; pages; pages &= pages - 1) {
+		if (memcmp(c->RAM + __builtin_ctzll(pages) * SIZE_PAGE, page,
+			SIZE_PAGE)) {
+			return 0;
+		}
+		page += SIZE_PAGE;
+	}
+
+	/*
+	 * The pages compared hold exactly the bytes translated, so only a corrupt
+	 * file can hold operands out of range; checking them is enough to keep
+	 * any from indexing past the registers or memory
+	 */
+	blocks = (const block*) page;
+	code = (const decoded*) (blocks + h->num_blocks);
+	for (j = 0; j < h->num_code; j++) {
+		if (code[j].op >= NUM_OPS || code[j].x >= NUM_REGS
+			|| code[j].y >= NUM_REGS || code[j].n > 0xF
+			|| code[j].nnn >= SIZE_MEM) {
+			return 0;
+		}
+	}
+
+	/*
+	 * Every block must lie within the code and the pages compared, each of its
+	 * instructions being the operation memory holds there
+	 */
+	for (j = 1; j < h->num_blocks; j++) {
+		if (blocks[j].start >= SIZE_MEM || !blocks[j].length
+			|| blocks[j].length > MAX_LENGTH
+			|| blocks[j].code + blocks[j].length > h->num_code) {
+			return 0;
+		}
+		for (k = 0; k < blocks[j].length; k++) {
+			a = blocks[j].start + 2 * k;
+			if (!_in(h->pages, a) || !_in(h->pages, a + 1)
+				|| code[blocks[j].code + k].op
+				!= decode_table[INSTR(c->RAM[MEM(a)], c->RAM[MEM(a + 1)])]) {
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+/*
+ * Take the blocks and instructions of the valid cache file at data as those
+ * of machine c.
+ */
+static void _adopt(chip8* c, const u_int8_t* data)
+{
+	const translation_header* h = (const translation_header*) data;
+	const block* blocks = (const block*) (data + sizeof(translation_header)
+		+ __builtin_popcountll(h->pages) * SIZE_PAGE);
+	const decoded* code = (const decoded*) (blocks + h->num_blocks);
+	translation* t = c->blocks;
+	int j;
+	int k;
+
+	if (t) {
+		flush_blocks(c);
+		t->num_blocks = h->num_blocks;
+		t->num_code = h->num_code;
+		for (j = 1; j < h->num_blocks; j++) {
+			t->blocks[j] = blocks[j];
+			memset(t->blocks[j].exit, 0, sizeof(t->blocks[j].exit));
+			memset(t->blocks[j].next, 0, sizeof(t->blocks[j].next));
+			index_block(c, j);
+		}
+		for (j = 0; j < h->num_code; j++) {
+			t->code[j].d = code[j];
+			t->code[j].fn = c->handlers[code[j].op];
+		}
+	}
+	if (c->cache) {
+		for (j = 1; j < h->num_blocks; j++) {
+			for (k = 0; k < blocks[j].length; k++) {
+				c->cache[MEM(blocks[j].start + 2 * k)] = code[blocks[j].code + k];
+			}
+		}
+	}
+}
+
+int load_translation(chip8* c, const char* dir)
+{
+	char path[PATH_SIZE];
+	struct stat st;
+	void* data;
+	int valid;
+	int fd;
+
+	_path(c, dir, path);
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+	if (fstat(fd, &st) || st.st_size < (off_t) sizeof(translation_header)) {
+		close(fd);
+		return -1;
+	}
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return -1;
+	}
+	valid = _valid(c, data, st.st_size);
+	if (valid) {
+		_adopt(c, data);
+	}
+	munmap(data, st.st_size);
+	return valid ? 0 : -1;
+}
+
+int save_translation(const chip8* c, const char* dir)
+{
+	const translation* t = c->blocks;
+	translation_header h;
+	char path[PATH_SIZE];
+	char temp[PATH_SIZE + 8];
+	u_int64_t pages;
+	block b;
+	int error;
+	int fd;
+	int j;
+	FILE* f;
+
+	if (!t) {
+		printf("No translated blocks to save\n");
+		return -1;
+	}
+	memset(&h, 0, sizeof(h));
+	h.magic = TRANSLATION_MAGIC;
+	h.version = TRANSLATION_VERSION;
+	h.quirks = c->quirks;
+	h.layout = LAYOUT;
+	h.hash = hash_rom(c);
+	h.pages = t->pages;
+	/* Discarded blocks are left out */
+	h.num_blocks = 1;
+	for (j = 1; j < t->num_blocks; j++) {
+		h.num_blocks += t->blocks[j].length != 0;
+	}
+	h.num_code = t->num_code;
+
+	_path(c, dir, path);
+	snprintf(temp, sizeof(temp), "%s.XXXXXX", path);
+	fd = mkstemp(temp);
+	if (fd < 0 || fchmod(fd, 0644) || !(f = fdopen(fd, "wb"))) {
+		printf("Error writing translation cache %s\n", path);
+		if (fd >= 0) {
+			close(fd);
+			unlink(temp);
+		}
+		return -1;
+	}
+	fwrite(&h, sizeof(h), 1, f);
+	for (pages = t->pages; pages; pages &= pages - 1) {
+		fwrite(c->RAM + __builtin_ctzll(pages) * SIZE_PAGE, SIZE_PAGE, 1, f);
+	}
+	for (j = 0; j < t->num_blocks; j++) {
+		/* Block 0 stands for no block; chaining is redone every run */
+		b = t->blocks[j];
+		if (!j) {
+			memset(&b, 0, sizeof(b));
+		} else if (!b.length) {
+			continue;
+		}
+		memset(b.exit, 0, sizeof(b.exit));
+		memset(b.next, 0, sizeof(b.next));
+		fwrite(&b, sizeof(b), 1, f);
+	}
+	for (j = 0; j < t->num_code; j++) {
+		fwrite(&t->code[j].d, sizeof(decoded), 1, f);
+	}
+	error = ferror(f);
+	if (fclose(f) || error || rename(temp, path)) {
+		printf("Error writing translation cache %s\n", path);
+		unlink(temp);
+		return -1;
+	}
+	return 0;
+}
+
+int warm_translation(chip8* c, const char* dir)
+{
+	translation* t;
+	int temporary = !c->blocks;
+	int j;
+	int k;
+
+	if (c->engine == ENGINE_INTERP || !load_translation(c, dir)) {
+		return 0;
+	}
+
+	/* Machines on ENGINE_CACHE only need the blocks to fill their cache */
+	if (temporary && alloc_blocks(c)) {
+		return -1;
+	}
+	t = c->blocks;
+	flush_blocks(c);
+	discover_blocks(c, c->PC);
+	save_translation(c, dir);
+	if (c->cache) {
+		for (j = 1; j < t->num_blocks; j++) {
+			for (k = 0; k < t->blocks[j].length; k++) {
+				c->cache[MEM(t->blocks[j].start + 2 * k)]
+					= t->code[t->blocks[j].code + k].d;
+			}
+		}
+	}
+	if (temporary) {
+		free(c->blocks);
+		c->blocks = NULL;
+	}
+	return 0;
+}
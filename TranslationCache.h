@@ -0,0 +1,80 @@
+/*
+ * Translation cache of the CHIP-8 emulator, kept on disk.
+ *
+ * Instead of discovering and translating the basic blocks of a ROM anew in
+ * every process, the blocks translated ahead of time from a ROM are written
+ * to a file in a cache directory, named after the hash of the ROM (see
+ * hash_rom) and its quirk profile:
+ *     <dir>/<hash>-<profile>.tc
+ * Later runs of the same ROM map the file and take its blocks, and the
+ * predecoded instructions they hold, as they are. A file holds:
+ *     translation_header
+ *     the bytes of every page of memory holding translated code, in order
+ *     the blocks, each a block (see BlockEngine.h) without its chaining
+ *     the instructions of the blocks, each a decoded
+ * A file is only used if its header matches the ROM, profile and build, and
+ * the pages it holds match the memory of the machine byte for byte, so that
+ * a stale or foreign file can never run code the ROM doesn't hold.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef TRANSLATIONCACHE_H_
+#define TRANSLATIONCACHE_H_
+
+/* INCLUDE */
+#include "CHIP8Emulator.h"
+
+/* DEFINE */
+#define TRANSLATION_MAGIC   0x43544338 // "8CTC" in little endian
+#define TRANSLATION_VERSION 2          // changes whenever the format does
+
+/* TYPEDEFS */
+/* Header of a translation cache file */
+typedef struct translation_header {
+	u_int32_t magic;      // TRANSLATION_MAGIC
+	u_int16_t version;    // TRANSLATION_VERSION
+	u_int8_t quirks;      // QUIRKS_ profile the blocks were translated for
+	u_int8_t layout;      // sizeof(block) + sizeof(decoded) of the build
+	u_int64_t hash;       // hash_rom of the ROM translated
+	u_int64_t pages;      // pages of memory holding translated code
+	u_int16_t num_blocks; // number of blocks, including block 0
+	u_int16_t num_code;   // number of instructions in the blocks
+} translation_header;
+
+/* PROTOTYPES */
+/*
+ * Replace the translated blocks and predecoded instructions of machine c by
+ * those of the file for its ROM and profile in the cache directory dir.
+ *
+ * Returns 0 if they were, or -1, changing nothing, if there is no such file
+ * or it doesn't match c.
+ */
+int load_translation(chip8* c, const char* dir);
+
+/*
+ * Write the translated blocks of machine c to the file for its ROM and
+ * profile in the cache directory dir, replacing any file already there. The
+ * file is written under another name first and renamed, so threads and
+ * processes sharing dir never read half a file.
+ *
+ * Returns 0 on success. If c has no blocks or the file can't be written, an
+ * error message is printed and -1 is returned.
+ */
+int save_translation(const chip8* c, const char* dir);
+
+/*
+ * Bring machine c, on ENGINE_CACHE or ENGINE_BLOCK, to full speed before it
+ * runs: load its translation from dir, or if there is none, discover every
+ * block reachable from PC (see discover_blocks), save them to dir, and fill
+ * the instruction cache from them. Machines on ENGINE_INTERP are left alone.
+ *
+ * Returns -1 if there isn't enough memory, 0 otherwise; failing to save is
+ * not an error.
+ */
+int warm_translation(chip8* c, const char* dir);
+
+#endif
@@ -0,0 +1,50 @@
+#include <string.h>
+#include "TripleBuffer.h"
+
+void init_frames(triple_buffer* b)
+{
+	memset(b->frames, 0, sizeof(b->frames));
+	atomic_init(&b->middle, 1);
+	b->back = 0;
+	b->pending = 0;
+	b->front = 2;
+}
+
+void publish_frame(triple_buffer* b, const chip8* c)
+{
+	frame* f = &b->frames[b->back];
+	unsigned old;
+	int y;
+
+	if (c->hires) {
+		for (y = 0; y < HIRES_HEIGHT; y++) {
+			memcpy(f->hires_screen[y], HIRES_ROW(c, y),
+				sizeof(f->hires_screen[y]));
+		}
+	} else {
+		memcpy(f->screen, c->screen, sizeof(f->screen));
+	}
+	f->hires = c->hires;
+	/* The reader may have taken none of the frames published since */
+	f->dirty = c->dirty | b->pending;
+	old = atomic_exchange(&b->middle, b->back | FRAME_FRESH);
+	b->back = old & ~FRAME_FRESH;
+
+	/*
+	 * If the frame replaced was never taken, the reader still owes its rows
+	 * too; if it was, the reader has everything up to it
+	 */
+	b->pending = old & FRAME_FRESH ? f->dirty : c->dirty;
+}
+
+const frame* take_frame(triple_buffer* b)
+{
+	unsigned old;
+
+	if (!(atomic_load(&b->middle) & FRAME_FRESH)) {
+		return NULL;
+	}
+	old = atomic_exchange(&b->middle, b->front);
+	b->front = old & ~FRAME_FRESH;
+	return &b->frames[b->front];
+}
@@ -0,0 +1,79 @@
+/*
+ * Lock-free handoff of frames from one thread to another.
+ *
+ * A triple buffer holds three frames: the writer draws into its back frame
+ * while the reader shows its front frame, and the third, in the middle, holds
+ * the newest frame published and not yet taken. Publishing swaps the back
+ * frame with the middle one and taking swaps the front frame with it, each by
+ * a single atomic exchange, so neither thread ever waits for the other. The
+ * writer never blocks on a slow reader; the reader skips straight to the
+ * newest frame.
+ *
+ * Each frame records which rows changed since the frame the reader last took,
+ * including the changes of any frames it skipped, so a reader redrawing only
+ * the changed rows of the newest frame stays correct.
+ *
+ * There must be one writer thread and one reader thread.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef TRIPLEBUFFER_H_
+#define TRIPLEBUFFER_H_
+
+/* INCLUDE */
+#include <stdatomic.h>
+#include "InstructionSet.h"
+
+/* DEFINE */
+#define FRAME_FRESH 4 // middle holds a frame which has not been taken yet
+
+/* TYPEDEFS */
+/* Screen of a machine as it was published */
+typedef struct frame {
+	union {
+		u_int64_t screen[HEIGHT]; // rows of the CHIP-8 screen, as in chip8
+		/* Rows of the hi-res screen, in order from the top */
+		u_int64_t hires_screen[HIRES_HEIGHT][HIRES_WORDS];
+	};
+	u_int64_t dirty; // rows changed since the last frame taken
+	u_int8_t hires;  // frame holds the hi-res screen rather than the CHIP-8 one
+} frame;
+
+typedef struct triple_buffer {
+	frame frames[3];
+
+	/* Index of the middle frame, with FRAME_FRESH if not taken yet */
+	_Alignas(64) atomic_uint middle;
+
+	/* Owned by the writer */
+	_Alignas(64) u_int32_t back; // index of the frame written next
+	u_int64_t pending;           // rows published since a frame known taken
+
+	/* Owned by the reader */
+	_Alignas(64) u_int32_t front; // index of the frame taken last
+} triple_buffer;
+
+/* PROTOTYPES */
+/*
+ * Empty triple buffer b: every frame blank, none published.
+ */
+void init_frames(triple_buffer* b);
+
+/*
+ * Publish the screen machine c shows, and the rows it marks as dirty, to b.
+ * Called by the writer only.
+ */
+void publish_frame(triple_buffer* b, const chip8* c);
+
+/*
+ * Return the newest frame published to b if it was not taken yet, or NULL.
+ * The frame stays valid and unchanged until the next call. Called by the
+ * reader only.
+ */
+const frame* take_frame(triple_buffer* b);
+
+#endif
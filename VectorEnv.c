@@ -0,0 +1,497 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Quirks.h"
+#include "VectorEnv.h"
+
+/* Value a of lanes in mask m, and b of the others */
+#define BLEND(m, a, b) (((a) & (m)) | ((b) & ~(m)))
+/* Mask m of a lane widened to 16 bits */
+#define WIDE(m) ((u_int16_t) -((m) & 1))
+
+/*
+ * Allocate an array of e's padded number of lanes, each of size bytes.
+ */
+static void* _lanes(const vector_env* e, size_t size)
+{
+	void* p = aligned_alloc(LANE_ALIGN, e->padded * size);
+
+	if (p) {
+		memset(p, 0, e->padded * size);
+	}
+	return p;
+}
+
+vector_env* alloc_vector(u_int32_t lanes)
+{
+	vector_env* e = calloc(1, sizeof(vector_env));
+	int r;
+
+	if (!e) {
+		return NULL;
+	}
+	e->lanes = lanes;
+	e->padded = (lanes + LANE_ALIGN - 1) / LANE_ALIGN * LANE_ALIGN;
+	for (r = 0; r < NUM_REGS; r++) {
+		e->v[r] = _lanes(e, sizeof(u_int8_t));
+	}
+	e->PC = _lanes(e, sizeof(u_int16_t));
+	e->I = _lanes(e, sizeof(u_int16_t));
+	e->sp = _lanes(e, sizeof(u_int16_t));
+	e->delay_timer = _lanes(e, sizeof(u_int8_t));
+	e->sound_timer = _lanes(e, sizeof(u_int8_t));
+	e->halt = _lanes(e, sizeof(u_int8_t));
+	e->idle = _lanes(e, sizeof(u_int8_t));
+	e->instr = _lanes(e, sizeof(u_int16_t));
+	e->pending = _lanes(e, sizeof(u_int8_t));
+	e->mask = _lanes(e, sizeof(u_int8_t));
+	e->rng = _lanes(e, sizeof(u_int32_t));
+	e->touched = _lanes(e, sizeof(u_int64_t));
+	e->machines = calloc(lanes ? lanes : 1, sizeof(chip8));
+	for (r = 0; r < NUM_REGS; r++) {
+		if (!e->v[r]) {
+			break;
+		}
+	}
+	if (r < NUM_REGS || !e->PC || !e->I || !e->sp || !e->delay_timer
+		|| !e->sound_timer || !e->halt || !e->idle || !e->instr
+		|| !e->pending || !e->mask || !e->rng || !e->touched || !e->machines) {
+		free_vector(e);
+		return NULL;
+	}
+	return e;
+}
+
+void free_vector(vector_env* e)
+{
+	int r;
+
+	for (r = 0; r < NUM_REGS; r++) {
+		free(e->v[r]);
+	}
+	free(e->PC);
+	free(e->I);
+	free(e->sp);
+	free(e->delay_timer);
+	free(e->sound_timer);
+	free(e->halt);
+	free(e->idle);
+	free(e->instr);
+	free(e->pending);
+	free(e->mask);
+	free(e->rng);
+	free(e->touched);
+	free(e->machines);
+	free(e);
+}
+
+/*
+ * Copy the registers of lane l of e into its machine.
+ */
+static void _gather(vector_env* e, u_int32_t l)
+{
+	chip8* c = &e->machines[l];
+	int r;
+
+	for (r = 0; r < NUM_REGS; r++) {
+		c->v[r] = e->v[r][l];
+	}
+	c->PC = e->PC[l];
+	c->I = e->I[l];
+	c->sp = e->sp[l];
+	c->delay_timer = e->delay_timer[l];
+	c->sound_timer = e->sound_timer[l];
+	c->halt = e->halt[l];
+	c->idle = e->idle[l];
+	c->rng = e->rng[l];
+}
+
+/*
+ * Copy the registers of the machine of lane l of e into e.
+ */
+static void _scatter(vector_env* e, u_int32_t l)
+{
+	const chip8* c = &e->machines[l];
+	int r;
+
+	for (r = 0; r < NUM_REGS; r++) {
+		e->v[r][l] = c->v[r];
+	}
+	e->PC[l] = c->PC;
+	e->I[l] = c->I;
+	e->sp[l] = c->sp;
+	e->delay_timer[l] = c->delay_timer;
+	e->sound_timer[l] = c->sound_timer;
+	e->halt[l] = c->halt;
+	e->idle[l] = c->idle;
+	e->rng[l] = c->rng;
+	e->touched[l] = c->touched;
+}
+
+void vector_load(vector_env* e, const chip8* image)
+{
+	u_int32_t l;
+
+	memcpy(e->image, image->RAM, SIZE_MEM);
+	e->shift_vy = quirk_profiles[image->quirks]->shift_vy;
+	for (l = 0; l < e->lanes; l++) {
+		e->machines[l] = *image;
+		e->machines[l].touched = 0;
+		e->machines[l].engine = ENGINE_INTERP;
+		e->machines[l].cache = NULL;
+		e->machines[l].blocks = NULL;
+		_scatter(e, l);
+	}
+}
+
+void vector_reset(vector_env* e, u_int32_t l, const save_state* image)
+{
+	reset_machine(&e->machines[l], image);
+	_scatter(e, l);
+}
+
+chip8* vector_lane(vector_env* e, u_int32_t l)
+{
+	_gather(e, l);
+	return &e->machines[l];
+}
+
+void vector_seed(vector_env* e, u_int32_t l, u_int32_t seed)
+{
+	seed_rng(&e->machines[l], seed);
+	e->rng[l] = e->machines[l].rng;
+}
+
+void vector_keys(vector_env* e, u_int32_t l, u_int16_t mask)
+{
+	set_key_mask(&e->machines[l], mask);
+	e->idle[l] = 0;
+}
+
+/*
+ * Execute the instruction i at address pc on every lane of e in mask, all of
+ * which are about to execute it, with one masked loop per register written.
+ *
+ * Returns 0 without executing anything if i is not one of the instructions
+ * which are executed this way.
+ */
+static int _vector(vector_env* e, const u_int8_t* m, address pc, instruction i)
+{
+	decoded d;
+	u_int8_t* vx;
+	u_int8_t* vy;
+	u_int8_t* vs;
+	u_int8_t* vf = e->v[0xF];
+	u_int16_t* PC = e->PC;
+	u_int32_t n = e->padded;
+	u_int32_t l;
+	u_int32_t r;
+
+	predecode(i, &d);
+	vx = e->v[d.x];
+	vy = e->v[d.y];
+	/* Register SHR and SHL shift */
+	vs = e->shift_vy ? vy : vx;
+	switch (d.op) {
+		case OP_JP:
+			if (d.nnn + 6 == pc + 2) {
+				/* Possibly a delay-wait loop, which reads memory to detect */
+				return 0;
+			}
+			for (l = 0; l < n; l++) {
+				PC[l] = BLEND(WIDE(m[l]), d.nnn, PC[l]);
+			}
+			if (d.nnn == pc) {
+				for (l = 0; l < n; l++) {
+					e->idle[l] |= m[l] & 1;
+				}
+			}
+			return 1;
+		case OP_SE: case OP_SNEI: case OP_SR: case OP_SNE: case OP_LDB:
+		case OP_ADDI: case OP_LDR: case OP_OR: case OP_AND: case OP_XOR:
+		case OP_ADD: case OP_SUB: case OP_SHR: case OP_SUBN: case OP_SHL:
+		case OP_RND: case OP_LDI: case OP_LDD: case OP_STD: case OP_STS:
+		case OP_IINC:
+			break;
+		default:
+			return 0;
+	}
+
+	/* Instruction was fetched */
+	for (l = 0; l < n; l++) {
+		PC[l] += m[l] & 2;
+	}
+	switch (d.op) {
+		case OP_SE:
+			for (l = 0; l < n; l++) {
+				PC[l] += m[l] & -(vx[l] == d.kk) & 2;
+			}
+			break;
+		case OP_SNEI:
+			for (l = 0; l < n; l++) {
+				PC[l] += m[l] & -(vx[l] != d.kk) & 2;
+			}
+			break;
+		case OP_SR:
+			for (l = 0; l < n; l++) {
+				PC[l] += m[l] & -(vx[l] == vy[l]) & 2;
+			}
+			break;
+		case OP_SNE:
+			for (l = 0; l < n; l++) {
+				PC[l] += m[l] & -(vx[l] != vy[l]) & 2;
+			}
+			break;
+		case OP_LDB:
+			for (l = 0; l < n; l++) {
+				vx[l] = BLEND(m[l], d.kk, vx[l]);
+			}
+			break;
+		case OP_ADDI:
+			for (l = 0; l < n; l++) {
+				vx[l] = BLEND(m[l], vx[l] + d.kk, vx[l]);
+			}
+			break;
+		case OP_LDR:
+			for (l = 0; l < n; l++) {
+				vx[l] = BLEND(m[l], vy[l], vx[l]);
+			}
+			break;
+		case OP_OR:
+			for (l = 0; l < n; l++) {
+				vx[l] |= vy[l] & m[l];
+			}
+			break;
+		case OP_AND:
+			for (l = 0; l < n; l++) {
+				vx[l] &= vy[l] | ~m[l];
+			}
+			break;
+		case OP_XOR:
+			for (l = 0; l < n; l++) {
+				vx[l] ^= vy[l] & m[l];
+			}
+			break;
+		/*
+		 * VF is written before Vx, as the scalar instructions do, so that the
+		 * result is the same when x or y is F
+		 */
+		case OP_ADD:
+			for (l = 0; l < n; l++) {
+				vf[l] = BLEND(m[l], vx[l] > 0xFF - vy[l], vf[l]);
+			}
+			for (l = 0; l < n; l++) {
+				vx[l] = BLEND(m[l], vx[l] + vy[l], vx[l]);
+			}
+			break;
+		case OP_SUB:
+			for (l = 0; l < n; l++) {
+				vf[l] = BLEND(m[l], vy[l] <= vx[l], vf[l]);
+			}
+			for (l = 0; l < n; l++) {
+				vx[l] = BLEND(m[l], vx[l] - vy[l], vx[l]);
+			}
+			break;
+		case OP_SHR:
+			for (l = 0; l < n; l++) {
+				vf[l] = BLEND(m[l], LSBI(vs[l]), vf[l]);
+			}
+			for (l = 0; l < n; l++) {
+				vx[l] = BLEND(m[l], vs[l] >> 1, vx[l]);
+			}
+			break;
+		case OP_SUBN:
+			for (l = 0; l < n; l++) {
+				vf[l] = BLEND(m[l], vx[l] <= vy[l], vf[l]);
+			}
+			for (l = 0; l < n; l++) {
+				vx[l] = BLEND(m[l], vy[l] - vx[l], vx[l]);
+			}
+			break;
+		case OP_SHL:
+			for (l = 0; l < n; l++) {
+				vf[l] = BLEND(m[l], MSBR(vs[l]), vf[l]);
+			}
+			for (l = 0; l < n; l++) {
+				vx[l] = BLEND(m[l], vs[l] << 1, vx[l]);
+			}
+			break;
+		case OP_RND:
+			/* The same xorshift32 step as RND, on every lane's generator */
+			for (l = 0; l < n; l++) {
+				r = e->rng[l];
+				r ^= r << 13;
+				r ^= r >> 17;
+				r ^= r << 5;
+				e->rng[l] = BLEND(-(u_int32_t) (m[l] & 1), r, e->rng[l]);
+			}
+			for (l = 0; l < n; l++) {
+				vx[l] = BLEND(m[l], (e->rng[l] >> 24) & d.kk, vx[l]);
+			}
+			break;
+		case OP_LDI:
+			for (l = 0; l < n; l++) {
+				e->I[l] = BLEND(WIDE(m[l]), d.nnn, e->I[l]);
+			}
+			break;
+		case OP_LDD:
+			for (l = 0; l < n; l++) {
+				vx[l] = BLEND(m[l], e->delay_timer[l], vx[l]);
+			}
+			break;
+		case OP_STD:
+			for (l = 0; l < n; l++) {
+				e->delay_timer[l] = BLEND(m[l], vx[l], e->delay_timer[l]);
+			}
+			break;
+		case OP_STS:
+			for (l = 0; l < n; l++) {
+				e->sound_timer[l] = BLEND(m[l], vx[l], e->sound_timer[l]);
+			}
+			break;
+		case OP_IINC:
+			for (l = 0; l < n; l++) {
+				vf[l] = BLEND(m[l], e->I[l] + vx[l] > 0xFFF, vf[l]);
+			}
+			for (l = 0; l < n; l++) {
+				e->I[l] = BLEND(WIDE(m[l]), e->I[l] + vx[l], e->I[l]);
+			}
+			break;
+	}
+	return 1;
+}
+
+/*
+ * Execute the next instruction of lane l of e on its own machine.
+ */
+static void _scalar(vector_env* e, u_int32_t l)
+{
+	chip8* c = &e->machines[l];
+
+	_gather(e, l);
+	execute(c, fetch(c));
+	_scatter(e, l);
+}
+
+/*
+ * Run one cycle on e. Returns 0 if every lane was halted or idle, so that
+ * nothing was executed.
+ */
+static int _cycle(vector_env* e)
+{
+	const u_int8_t* ram;
+	u_int8_t* pending = e->pending;
+	u_int8_t* mask = e->mask;
+	u_int16_t* instr = e->instr;
+	u_int16_t* PC = e->PC;
+	const u_int8_t* halt = e->halt;
+	const u_int8_t* idle = e->idle;
+	const u_int64_t* written = e->touched;
+	u_int32_t n = e->padded;
+	u_int32_t lanes = e->lanes;
+	u_int64_t pages;
+	u_int64_t touched = 0;
+	u_int32_t l;
+	u_int32_t leader;
+	u_int32_t count;
+	u_int32_t groups;
+	u_int32_t running = 0;
+	u_int16_t diverged = 0;
+	address pc;
+	instruction i;
+
+	for (l = 0; l < n; l++) {
+		pending[l] = -!(halt[l] | idle[l]) & -(l < lanes);
+		running += pending[l] & 1;
+	}
+	if (!running) {
+		return 0;
+	}
+	for (leader = 0; !pending[leader]; leader++);
+	pc = PC[leader];
+	pages = (1ULL << (MEM(pc) / SIZE_PAGE)) | (1ULL << (MEM(pc + 1) / SIZE_PAGE));
+
+	/*
+	 * Lanes usually run in step: all at the same address, which none of them
+	 * wrote to, so all about to execute the instruction the image holds there
+	 */
+	for (l = 0; l < n; l++) {
+		diverged |= WIDE(pending[l]) & (PC[l] ^ pc);
+		touched |= written[l] & -(u_int64_t) (pending[l] & 1);
+	}
+	if (!diverged && !(touched & pages)) {
+		i = INSTR(e->image[MEM(pc)], e->image[MEM(pc + 1)]);
+		if (running < MIN_GROUP || !_vector(e, pending, pc, i)) {
+			for (l = leader; l < lanes; l++) {
+				if (pending[l]) {
+					_scalar(e, l);
+				}
+			}
+		}
+		return 1;
+	}
+
+	for (l = 0; l < lanes; l++) {
+		pc = PC[l];
+		/* Lanes which never wrote to where pc is still hold the image there */
+		ram = written[l] & ((1ULL << (MEM(pc) / SIZE_PAGE))
+			| (1ULL << (MEM(pc + 1) / SIZE_PAGE))) ? e->machines[l].RAM
+			: e->image;
+		instr[l] = INSTR(ram[MEM(pc)], ram[MEM(pc + 1)]);
+	}
+
+	/* Otherwise execute the largest groups together, led by the first lane */
+	for (groups = 0; groups < MAX_GROUPS; groups++) {
+		while (leader < lanes && !pending[leader]) {
+			leader++;
+		}
+		if (leader == lanes) {
+			return 1;
+		}
+		pc = PC[leader];
+		i = instr[leader];
+		count = 0;
+		for (l = 0; l < n; l++) {
+			mask[l] = pending[l] & -((PC[l] == pc) & (instr[l] == i));
+			count += mask[l] & 1;
+		}
+		if (count < MIN_GROUP || !_vector(e, mask, pc, i)) {
+			/* Whoever isn't worth it or can't be run together runs alone */
+			for (l = leader; l < lanes; l++) {
+				if (mask[l]) {
+					_scalar(e, l);
+				}
+			}
+		}
+		for (l = 0; l < n; l++) {
+			pending[l] &= ~mask[l];
+		}
+		running -= count;
+		if (!running) {
+			return 1;
+		}
+	}
+
+	for (l = leader; l < lanes; l++) {
+		if (pending[l]) {
+			_scalar(e, l);
+		}
+	}
+	return 1;
+}
+
+void vector_run(vector_env* e, u_int32_t n)
+{
+	while (n-- && _cycle(e));
+}
+
+void vector_frame(vector_env* e, u_int32_t n)
+{
+	u_int32_t l;
+
+	vector_run(e, n);
+	for (l = 0; l < e->padded; l++) {
+		e->delay_timer[l] -= e->delay_timer[l] > 0;
+		e->sound_timer[l] -= e->sound_timer[l] > 0;
+		e->idle[l] = 0;
+	}
+}
@@ -0,0 +1,136 @@
+/*
+ * Lockstep execution of many CHIP-8 machines at once.
+ *
+ * A vector environment holds a number of lanes, each a machine usually
+ * running the same ROM with its own input and seed. The registers of all
+ * lanes (V0 to VF, PC, I, the stack pointer, the timers, and the halt and idle
+ * registers, and the random number generator) are stored as structure of
+ * arrays: one array per register, indexed by lane. Memory, the screen and the
+ * keys of each lane stay in a machine of its own. Lanes fetch from the
+ * memory they were all loaded with, shared, until they write to it.
+ *
+ * Every cycle, each lane which is neither halted nor idle executes one
+ * instruction. Lanes at the same address about to execute the same
+ * instruction are grouped together; for the arithmetic, load, skip and jump
+ * instructions which only touch registers, a whole group is executed by one
+ * loop over the register arrays, masked to the lanes of the group, which the
+ * compiler turns into SIMD instructions. Lanes which diverged into groups too
+ * small to be worth it, and every other instruction, are executed one lane at
+ * a time by copying its registers into its machine, running the instruction
+ * there, and copying them back.
+ *
+ * Lanes run exactly as they would each on their own ENGINE_INTERP machine,
+ * with the quirk profile of the machine they were loaded with.
+ *
+ * CREATED:
+ * 2026-10-14
+ *
+ * AUTHOR:
+ * Nikola Istvanic
+ */
+#ifndef VECTORENV_H_
+#define VECTORENV_H_
+
+/* INCLUDE */
+#include "CHIP8Emulator.h"
+#include "SaveState.h"
+
+/* DEFINE */
+#define LANE_ALIGN 64 // alignment and padding of the register arrays
+#define MIN_GROUP  4  // fewest lanes executed together by a masked loop
+#define MAX_GROUPS 16  // most groups executed together per cycle
+
+/* TYPEDEFS */
+typedef struct vector_env {
+	u_int32_t lanes;  // number of lanes
+	u_int32_t padded; // lanes rounded up to LANE_ALIGN
+
+	/* Registers of every lane, one array per register indexed by lane */
+	u_int8_t* v[NUM_REGS];
+	u_int16_t* PC;
+	u_int16_t* I;
+	u_int16_t* sp;
+	u_int8_t* delay_timer;
+	u_int8_t* sound_timer;
+	u_int8_t* halt;
+	u_int8_t* idle;
+	u_int32_t* rng;
+	u_int64_t* touched; // pages of memory the lane wrote to since loaded
+
+	/* SHR and SHL shift Vy, by the quirk profile every lane runs with */
+	u_int8_t shift_vy;
+
+	/*
+	 * Machine of each lane, holding its memory, screen and keys. Its registers
+	 * are only up to date after vector_lane.
+	 */
+	chip8* machines;
+
+	/*
+	 * Memory every lane was loaded with. Instructions are fetched from here
+	 * rather than from the memory of a lane unless the lane wrote to it.
+	 */
+	u_int8_t image[SIZE_MEM];
+
+	/* Scratch space of one cycle */
+	u_int16_t* instr;  // instruction each lane is about to execute
+	u_int8_t* pending; // lane has yet to execute this cycle (0xFF) or not (0)
+	u_int8_t* mask;    // lane is in the group being executed (0xFF) or not (0)
+} vector_env;
+
+/* PROTOTYPES */
+/*
+ * Allocate a vector environment of lanes lanes. Returns NULL if there isn't
+ * enough memory.
+ */
+vector_env* alloc_vector(u_int32_t lanes);
+
+/*
+ * Free vector environment e.
+ */
+void free_vector(vector_env* e);
+
+/*
+ * Set every lane of e to a copy of machine image, such as one just initialized
+ * with a ROM loaded. The lanes run on ENGINE_INTERP whatever image runs on.
+ */
+void vector_load(vector_env* e, const chip8* image);
+
+/*
+ * Reset lane l of e to image, a state of the machine e was loaded with taken
+ * while nothing was touched (see reset_machine), copying back only what the
+ * lane wrote to since.
+ */
+void vector_reset(vector_env* e, u_int32_t l, const save_state* image);
+
+/*
+ * Return the machine of lane l of e with its registers brought up to date.
+ * Changes made to the registers of the machine are not seen by e; change its
+ * seed with vector_seed, its keys with vector_keys, and its memory only
+ * through write_mem.
+ */
+chip8* vector_lane(vector_env* e, u_int32_t l);
+
+/*
+ * Seed the random number generator of lane l of e with seed (see seed_rng).
+ */
+void vector_seed(vector_env* e, u_int32_t l, u_int32_t seed);
+
+/*
+ * Set the keys of lane l of e to those held down by mask, bit k for key k.
+ */
+void vector_keys(vector_env* e, u_int32_t l, u_int16_t mask);
+
+/*
+ * Run n cycles on e; in each cycle every lane which is neither halted nor idle
+ * executes one instruction. Stops early once every lane is halted or idle.
+ */
+void vector_run(vector_env* e, u_int32_t n);
+
+/*
+ * Run one frame on e: n cycles, after which the timers of every lane are
+ * decremented and no lane is idle anymore.
+ */
+void vector_frame(vector_env* e, u_int32_t n);
+
+#endif